@@ -0,0 +1,544 @@
+#pragma once
+
+/*
+Пакетный режим: один процесс решает поток задач, не спрашивая ничего у пользователя.
+
+Источники задач (аргументы командной строки):
+    --batch                 - стандартный ввод: задачи в текстовом формате идут подряд ("n max_weight" и n пар "стоимость вес");
+    --batch_dir=каталог     - каждый файл каталога (текстовый или двоичный, см. instance_loader.h) - отдельная задача;
+    --batch_socket=путь     - сервер на локальном Unix-сокете: клиент пишет задачи как в --batch, ответы приходят в то же соединение;
+    --batch_threads=k       - число потоков решения (по умолчанию - число ядер).
+
+Задачи решаются пулом потоков, ответы выводятся по мере готовности, по строке на задачу:
+    имя <TAB> стоимость <TAB> загрузка, мс <TAB> решение, мс <TAB> индексы взятых предметов через пробел
+или "имя <TAB> error <TAB> сообщение". Имя - имя файла или номер задачи в потоке (с нуля).
+
+У каждого потока решения свое рабочее пространство Workspace (тип задает решатель), оно создается один раз и
+переиспользуется между задачами; заявки с буферами стоимостей и весов тоже возвращаются в пул и переиспользуются.
+*/
+
+#include <iostream>
+#include <string>
+#include <vector>
+#include <deque>
+#include <memory>
+#include <thread>
+#include <mutex>
+#include <atomic>
+#include <condition_variable>
+#include <filesystem>
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cerrno>
+#include <cstring>
+#include "instance_loader.h"
+#if !defined(_WIN32)
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+#endif
+
+#if !defined(ACCEPT_RETRY_DELAY)
+#define ACCEPT_RETRY_DELAY 100 // мс до следующего accept, когда у процесса кончились дескрипторы или память
+#endif
+
+enum class BatchSource {
+    none, // обычный интерактивный режим
+    input_stream,
+    directory,
+    socket
+};
+
+struct BatchOptions {
+    BatchSource source = BatchSource::none;
+    std::string path; // каталог или путь сокета
+    int threads_count = 0; // 0 - по числу ядер
+};
+
+/*
+Забирает из argv аргументы пакетного режима, остальные аргументы сдвигаются в начало (argc уменьшается),
+чтобы их разобрал сам решатель. При ошибке выводит сообщение и возвращает false.
+*/
+inline bool parse_batch_arguments(int& argc, char* argv[], BatchOptions& options) {
+    int kept = 1;
+    for (int i = 1; i < argc; ++i) {
+        std::string argument = argv[i];
+        if (argument == "--batch") {
+            options.source = BatchSource::input_stream;
+        } else if (argument.rfind("--batch_dir=", 0) == 0) {
+            options.source = BatchSource::directory;
+            options.path = argument.substr(12);
+        } else if (argument.rfind("--batch_socket=", 0) == 0) {
+#if defined(_WIN32)
+            std::cerr << "Error: --batch_socket is not supported on this platform.\n";
+            return false;
+#else
+            options.source = BatchSource::socket;
+            options.path = argument.substr(15);
+#endif
+        } else if (argument.rfind("--batch_threads=", 0) == 0) {
+            auto [end, error] = std::from_chars(argument.data() + 16, argument.data() + argument.size(), options.threads_count);
+            if (error != std::errc() || end != argument.data() + argument.size() || options.threads_count <= 0) {
+                std::cerr << "Error: invalid value of --batch_threads.\n";
+                return false;
+            }
+        } else {
+            argv[kept++] = argv[i];
+        }
+    }
+    argc = kept;
+    return true;
+}
+
+// число потоков решения
+inline int batch_workers_count(const BatchOptions& options) noexcept {
+    return 0 < options.threads_count ? options.threads_count : static_cast<int>(std::max(1u, std::thread::hardware_concurrency()));
+}
+
+/*
+Куда пишутся ответы: стандартный вывод или соединение. Потоки решения не должны ждать клиента, который еще передает
+задачи и не читает ответы, иначе один такой клиент остановил бы весь пул: в сокет пишется без ожидания, а что не
+поместилось в буфер сокета - копится и дописывается в drain, когда все задачи соединения решены.
+*/
+class BatchOutput {
+public:
+    explicit BatchOutput(std::FILE* file) noexcept :
+        file_(file) {}
+
+#if !defined(_WIN32)
+    explicit BatchOutput(int socket) noexcept :
+        socket_(socket) {}
+#endif
+
+    BatchOutput(const BatchOutput&) = delete;
+    BatchOutput& operator=(const BatchOutput&) = delete;
+
+    ~BatchOutput() noexcept {
+#if !defined(_WIN32)
+        if (0 <= socket_) {
+            close(socket_);
+        }
+#endif
+    }
+
+    // задача поставлена в очередь, ответ на нее придет через complete
+    void expect() noexcept {
+        std::lock_guard<std::mutex> lock(mutex_);
+        ++in_flight_;
+    }
+
+    void complete(const std::string& line) noexcept {
+        std::lock_guard<std::mutex> lock(mutex_);
+        append(line, false);
+        --in_flight_;
+        if (in_flight_ == 0) {
+            done_.notify_all();
+        }
+    }
+
+    void write(const std::string& line) noexcept {
+        std::lock_guard<std::mutex> lock(mutex_);
+        append(line, false);
+    }
+
+    // ждет ответов на все поставленные задачи и дописывает накопленное
+    void drain() noexcept {
+        std::unique_lock<std::mutex> lock(mutex_);
+        done_.wait(lock, [&]() { return in_flight_ == 0; });
+        append(std::string(), true);
+    }
+
+private:
+    void append(const std::string& line, bool wait) noexcept {
+        if (file_ != nullptr) {
+            std::fwrite(line.data(), 1, line.size(), file_);
+            std::fflush(file_);
+            return;
+        }
+#if !defined(_WIN32)
+        if (broken_) {
+            return; // клиент отключился - ответы некуда отправить
+        }
+        pending_ += line;
+        size_t written = 0;
+        while (written < pending_.size()) {
+            ssize_t result = send(socket_, pending_.data() + written, pending_.size() - written, wait ? MSG_NOSIGNAL : MSG_NOSIGNAL | MSG_DONTWAIT);
+            if (result < 0 && !wait && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+                break;
+            }
+            if (result <= 0) {
+                broken_ = true;
+                pending_.clear();
+                return;
+            }
+            written += static_cast<size_t>(result);
+        }
+        pending_.erase(0, written);
+#endif
+    }
+
+    std::mutex mutex_;
+    std::condition_variable done_;
+    long long in_flight_ = 0;
+    std::FILE* file_ = nullptr;
+#if !defined(_WIN32)
+    int socket_ = -1;
+    std::string pending_;
+    bool broken_ = false;
+#endif
+};
+
+struct BatchRequest {
+    std::string name;
+    std::string path; // файл, который поток решения загрузит сам; пусто - данные уже в instance
+    LoadedInstance instance;
+    std::shared_ptr<BatchOutput> output;
+};
+
+/*
+Ограниченная очередь заявок: источник ждет, если решатели не успевают, поэтому память не растет на длинном потоке задач.
+Обработанные заявки возвращаются в список свободных вместе с выделенными буферами.
+*/
+class BatchQueue {
+public:
+    explicit BatchQueue(size_t capacity) noexcept :
+        capacity_(capacity) {}
+
+    std::unique_ptr<BatchRequest> acquire() {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (free_.empty()) {
+            return std::make_unique<BatchRequest>();
+        }
+        std::unique_ptr<BatchRequest> request = std::move(free_.back());
+        free_.pop_back();
+        return request;
+    }
+
+    void release(std::unique_ptr<BatchRequest> request) {
+        request->output.reset();
+        request->instance.mapping = MappedFile();
+        std::lock_guard<std::mutex> lock(mutex_);
+        free_.push_back(std::move(request));
+    }
+
+    void push(std::unique_ptr<BatchRequest> request) {
+        std::unique_lock<std::mutex> lock(mutex_);
+        not_full_.wait(lock, [&]() { return pending_.size() < capacity_; });
+        pending_.push_back(std::move(request));
+        not_empty_.notify_one();
+    }
+
+    // nullptr - очередь закрыта и пуста
+    std::unique_ptr<BatchRequest> pop() {
+        std::unique_lock<std::mutex> lock(mutex_);
+        not_empty_.wait(lock, [&]() { return !pending_.empty() || closed_; });
+        if (pending_.empty()) {
+            return nullptr;
+        }
+        std::unique_ptr<BatchRequest> request = std::move(pending_.front());
+        pending_.pop_front();
+        not_full_.notify_one();
+        return request;
+    }
+
+    void close() {
+        std::lock_guard<std::mutex> lock(mutex_);
+        closed_ = true;
+        not_empty_.notify_all();
+    }
+
+private:
+    size_t capacity_;
+    std::mutex mutex_;
+    std::condition_variable not_empty_;
+    std::condition_variable not_full_;
+    std::deque<std::unique_ptr<BatchRequest>> pending_;
+    std::vector<std::unique_ptr<BatchRequest>> free_;
+    bool closed_ = false;
+};
+
+// чтение целых из FILE* через свой буфер: числа могут разрываться границей буфера, поэтому разбор посимвольный
+class NumberReader {
+public:
+    explicit NumberReader(std::FILE* file) noexcept :
+        file_(file) {}
+
+    // false - конец ввода (error() == false) или не число (error() == true)
+    bool next(int& value) noexcept {
+        int symbol = skip_blanks();
+        if (symbol == EOF) {
+            return false;
+        }
+        bool negative = symbol == '-';
+        if (negative) {
+            ++position_;
+            symbol = peek();
+        }
+        long long number = 0;
+        int digits = 0;
+        while (symbol != EOF && '0' <= symbol && symbol <= '9') {
+            number = number * 10 + (symbol - '0');
+            if (INT32_MAX < number) {
+                break;
+            }
+            ++digits;
+            ++position_;
+            symbol = peek();
+        }
+        if (digits == 0 || INT32_MAX < number || (symbol != EOF && !is_blank(static_cast<char>(symbol)))) {
+            error_ = true;
+            return false;
+        }
+        value = static_cast<int>(negative ? -number : number);
+        return true;
+    }
+
+    bool error() const noexcept {
+        return error_;
+    }
+
+private:
+    int peek() noexcept {
+        if (position_ == size_) {
+            size_ = std::fread(buffer_, 1, sizeof(buffer_), file_);
+            position_ = 0;
+            if (size_ == 0) {
+                return EOF;
+            }
+        }
+        return static_cast<unsigned char>(buffer_[position_]);
+    }
+
+    int skip_blanks() noexcept {
+        int symbol = peek();
+        while (symbol != EOF && is_blank(static_cast<char>(symbol))) {
+            ++position_;
+            symbol = peek();
+        }
+        return symbol;
+    }
+
+    std::FILE* file_;
+    char buffer_[1 << 16];
+    size_t position_ = 0;
+    size_t size_ = 0;
+    bool error_ = false;
+};
+
+// задачи из текстового потока подряд до конца ввода; возвращает число прочитанных задач
+inline long long read_instances(std::FILE* file, const std::shared_ptr<BatchOutput>& output, BatchQueue& queue) {
+    auto reader = std::make_unique<NumberReader>(file); // буфер 64 КБ - не на стеке
+    long long index = 0;
+    while (true) {
+        int count, max_weight;
+        if (!reader->next(count)) {
+            break;
+        }
+        std::unique_ptr<BatchRequest> request = queue.acquire();
+        request->name = std::to_string(index);
+        request->path.clear();
+        request->output = output;
+        LoadedInstance& instance = request->instance;
+        bool parsed = 0 <= count && reader->next(max_weight);
+        if (parsed) {
+            instance.price_storage.resize(count);
+            instance.weight_storage.resize(count);
+            for (int i = 0; parsed && i < count; ++i) {
+                parsed = reader->next(instance.price_storage[i]) && reader->next(instance.weight_storage[i]);
+            }
+        }
+        if (!parsed) { // после ошибки границы следующей задачи неизвестны - чтение прекращается
+            output->write(request->name + "\terror\tmalformed instance: expected n, max weight and n pairs of integers\n");
+            queue.release(std::move(request));
+            return index;
+        }
+        instance.count = count;
+        instance.max_weight = max_weight;
+        instance.prices = instance.price_storage.data();
+        instance.weights = instance.weight_storage.data();
+        output->expect();
+        queue.push(std::move(request));
+        ++index;
+    }
+    if (reader->error()) {
+        output->write(std::to_string(index) + "\terror\tmalformed instance: expected n, max weight and n pairs of integers\n");
+    }
+    return index;
+}
+
+#if !defined(_WIN32)
+// соединение с клиентом сокета, которое читает свой поток; input закрывает сам поток под lock, поэтому сервер может
+// в любой момент закрыть соединение (shutdown), не рискуя попасть в уже переиспользованный дескриптор
+struct SocketReader {
+    std::mutex lock;
+    std::FILE* input = nullptr; // ввод соединения; nullptr - соединение закончено
+    std::thread thread;
+    std::atomic<bool> finished{false}; // поток можно присоединять
+};
+#endif
+
+/*
+Запускает пакетный режим. Workspace - рабочее пространство потока решения, конструируется от числа потоков решения
+(по нему решатель может ограничить собственный параллелизм). solve(const LoadedInstance&, Workspace&) возвращает
+решение с полями price и items. Возвращает код завершения процесса.
+*/
+template<typename Workspace, typename Solve>
+int run_batch(const BatchOptions& options, Solve solve) {
+    const int workers_count = batch_workers_count(options);
+    BatchQueue queue(2 * static_cast<size_t>(workers_count));
+    auto start = std::chrono::high_resolution_clock::now();
+
+    std::vector<std::thread> workers;
+    for (int w = 0; w < workers_count; ++w) {
+        workers.emplace_back([&]() {
+            Workspace workspace(workers_count);
+            std::string line;
+            while (std::unique_ptr<BatchRequest> request = queue.pop()) {
+                auto load_start = std::chrono::high_resolution_clock::now();
+                if (!request->path.empty() && !load_instance(request->path, request->instance)) {
+                    request->output->complete(request->name + "\terror\tcan't load the instance\n");
+                    queue.release(std::move(request));
+                    continue;
+                }
+                auto solve_start = std::chrono::high_resolution_clock::now();
+                auto solution = solve(request->instance, workspace);
+                auto solve_end = std::chrono::high_resolution_clock::now();
+
+                line = request->name;
+                line += '\t';
+                line += std::to_string(solution.price);
+                line += '\t';
+                line += std::to_string(std::chrono::duration<double, std::milli>(solve_start - load_start).count());
+                line += '\t';
+                line += std::to_string(std::chrono::duration<double, std::milli>(solve_end - solve_start).count());
+                line += '\t';
+                for (size_t i = 0; i < solution.items.size(); ++i) {
+                    if (i != 0) {
+                        line += ' ';
+                    }
+                    line += std::to_string(solution.items[i]);
+                }
+                line += '\n';
+                request->output->complete(line);
+                queue.release(std::move(request));
+            }
+        });
+    }
+
+    long long instances_count = 0;
+    bool failed = false;
+    if (options.source == BatchSource::input_stream) {
+        instances_count = read_instances(stdin, std::make_shared<BatchOutput>(stdout), queue);
+    } else if (options.source == BatchSource::directory) {
+        std::error_code error;
+        std::vector<std::filesystem::path> files;
+        for (const auto& entry : std::filesystem::directory_iterator(options.path, error)) {
+            if (entry.is_regular_file()) {
+                files.push_back(entry.path());
+            }
+        }
+        failed = static_cast<bool>(error);
+        if (failed) {
+            std::cerr << "Error: can't read the directory '" << options.path << "'.\n";
+        }
+        std::sort(files.begin(), files.end());
+        auto output = std::make_shared<BatchOutput>(stdout);
+        for (const auto& file : files) {
+            std::unique_ptr<BatchRequest> request = queue.acquire();
+            request->name = file.filename().string();
+            request->path = file.string();
+            request->output = output;
+            output->expect();
+            queue.push(std::move(request));
+        }
+        instances_count = static_cast<long long>(files.size());
+    }
+#if !defined(_WIN32)
+    else if (options.source == BatchSource::socket) {
+        int server = ::socket(AF_UNIX, SOCK_STREAM, 0);
+        sockaddr_un address{};
+        address.sun_family = AF_UNIX;
+        failed = server < 0 || sizeof(address.sun_path) <= options.path.size();
+        if (!failed) {
+            std::copy(options.path.begin(), options.path.end(), address.sun_path);
+            unlink(options.path.c_str()); // сокет, оставшийся от прошлого запуска
+            failed = bind(server, reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0 || listen(server, SOMAXCONN) != 0;
+        }
+        if (failed) {
+            std::cerr << "Error: can't listen on the socket '" << options.path << "'.\n";
+        } else {
+            std::cerr << "Listening on '" << options.path << "'\n";
+            std::vector<std::unique_ptr<SocketReader>> readers;
+            while (true) { // сервер работает до завершения процесса или до ошибки сокета
+                std::erase_if(readers, [](std::unique_ptr<SocketReader>& reader) { // потоки закончивших соединений
+                    if (!reader->finished.load(std::memory_order_acquire)) {
+                        return false;
+                    }
+                    reader->thread.join();
+                    return true;
+                });
+                int client = accept(server, nullptr, nullptr);
+                if (client < 0) {
+                    if (errno == EINTR || errno == ECONNABORTED) { // сорвалось одно соединение - следующее принимается сразу
+                        continue;
+                    }
+                    if (errno == EMFILE || errno == ENFILE || errno == ENOBUFS || errno == ENOMEM) {
+                        // кончились дескрипторы или память: ждем, пока закроются открытые соединения, вместо холостого цикла
+                        std::this_thread::sleep_for(std::chrono::milliseconds(ACCEPT_RETRY_DELAY));
+                        continue;
+                    }
+                    std::cerr << "Error: can't accept a connection on the socket '" << options.path << "': " << std::strerror(errno) << ".\n";
+                    failed = true;
+                    break;
+                }
+                int output_socket = dup(client);
+                std::FILE* input = output_socket < 0 ? nullptr : fdopen(client, "r");
+                if (input == nullptr) {
+                    if (0 <= output_socket) {
+                        ::close(output_socket);
+                    }
+                    ::close(client);
+                    continue;
+                }
+                auto reader = std::make_unique<SocketReader>();
+                reader->input = input;
+                reader->thread = std::thread([reader = reader.get(), output_socket, &queue]() { // соединение читается своим потоком, решают общие потоки пула
+                    auto output = std::make_shared<BatchOutput>(output_socket);
+                    read_instances(reader->input, output, queue);
+                    output->drain();
+                    std::lock_guard<std::mutex> guard(reader->lock);
+                    shutdown(fileno(reader->input), SHUT_RDWR);
+                    std::fclose(reader->input);
+                    reader->input = nullptr;
+                    reader->finished.store(true, std::memory_order_release);
+                });
+                readers.push_back(std::move(reader));
+            }
+            // очередь и потоки решения живут, пока не закончатся все соединения: открытые соединения закрываются
+            // (ответы на их задачи теряются), после чего их потоки дочитывают ввод, дожидаются своих задач и завершаются
+            for (auto& reader : readers) {
+                std::lock_guard<std::mutex> guard(reader->lock);
+                if (reader->input != nullptr) {
+                    shutdown(fileno(reader->input), SHUT_RDWR);
+                }
+            }
+            for (auto& reader : readers) {
+                reader->thread.join();
+            }
+        }
+        if (0 <= server) {
+            ::close(server);
+        }
+    }
+#endif
+
+    queue.close();
+    for (auto& worker : workers) {
+        worker.join();
+    }
+    auto time_spent = std::chrono::high_resolution_clock::now() - start;
+    std::cerr << "Instances: " << instances_count << ", threads: " << workers_count << ", total time: "
+        << std::chrono::duration<double, std::milli>(time_spent).count() << " milliseconds\n";
+    return failed ? 1 : 0;
+}
\ No newline at end of file
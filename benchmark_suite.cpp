@@ -0,0 +1,476 @@
+#include <iostream>
+#include <fstream>
+#include <string>
+#include <vector>
+#include <memory>
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cerrno>
+#include <cstdint>
+#include "solvers.h"
+#include "solver_session.h"
+#include "instance_generators.h"
+#if !defined(_WIN32)
+#include <csignal>
+#include <sys/resource.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#endif
+
+using namespace std;
+
+struct SuiteOptions {
+    vector<InstanceFamily> families{begin(INSTANCE_FAMILIES), end(INSTANCE_FAMILIES)};
+    vector<int> sizes{100, 1000};
+    vector<double> capacity_ratios{0.25, 0.5};
+    int range = 1000;
+    uint64_t instance_seed = 1;
+    int warmup = 1; // прогоны без замера перед замерами
+    int repetitions = 5;
+    int timeout = 10; // секунд на все прогоны одного решателя на одной задаче; 0 - без ограничения
+    string exact = "dynamic_programming"; // точный решатель, от ответа которого считается отставание
+    bool json = false;
+    string output; // пусто - стандартный вывод
+    bool compare_reduction = false; // каждый решатель замеряется еще и без предобработки задачи
+    int incremental = 0; // сколько предметов меняется перед каждым повторным решением в сессии; 0 - без замера сессий
+};
+
+enum class RunStatus {
+    ok,
+    timeout,
+    failed
+};
+
+const char* status_name(RunStatus status) noexcept {
+    return status == RunStatus::ok ? "ok" : status == RunStatus::timeout ? "timeout" : "failed";
+}
+
+struct Measurement {
+    RunStatus status = RunStatus::failed;
+    long long price = 0;
+    bool valid = false; // ответ помещается в рюкзак и его стоимость совпадает с суммой стоимостей предметов
+    vector<long long> times; // наносекунды, по прогону на элемент
+    long peak_rss = -1; // пиковая память процесса решения, КБ; -1 - неизвестна
+    int reduced_count = 0; // предметов после предобработки (см. reduce_instance)
+};
+
+// список через запятую
+template<typename T>
+bool parse_list(const string& text, vector<T>& values) {
+    values.clear();
+    for (size_t first = 0; first <= text.size();) {
+        size_t last = min(text.find(',', first), text.size());
+        T value;
+        if (!parse_number(text.substr(first, last - first), value) || !(0 < value)) {
+            return false;
+        }
+        values.push_back(value);
+        first = last + 1;
+    }
+    return true;
+}
+
+bool parse_families(const string& text, vector<InstanceFamily>& families) {
+    families.clear();
+    if (text == "all") {
+        families.assign(begin(INSTANCE_FAMILIES), end(INSTANCE_FAMILIES));
+        return true;
+    }
+    for (size_t first = 0; first <= text.size();) {
+        size_t last = min(text.find(',', first), text.size());
+        InstanceFamily family;
+        if (!parse_family(text.substr(first, last - first), family)) {
+            return false;
+        }
+        families.push_back(family);
+        first = last + 1;
+    }
+    return true;
+}
+
+// забирает из argv аргументы набора; остальные остаются решателям
+bool parse_suite_arguments(int& argc, char* argv[], SuiteOptions& options) {
+    int kept = 1;
+    for (int i = 1; i < argc; ++i) {
+        string argument = argv[i];
+        size_t separator = argument.find('=');
+        string name = argument.substr(0, separator);
+        string value = separator == string::npos ? "" : argument.substr(separator + 1);
+        bool parsed = true;
+        if (name == "--families") {
+            parsed = parse_families(value, options.families);
+        } else if (name == "--sizes") {
+            parsed = parse_list(value, options.sizes);
+        } else if (name == "--capacities") {
+            parsed = parse_list(value, options.capacity_ratios) && *max_element(options.capacity_ratios.begin(), options.capacity_ratios.end()) <= 1;
+        } else if (name == "--range") {
+            parsed = parse_number(value, options.range) && 0 < options.range;
+        } else if (name == "--instance_seed") {
+            parsed = parse_number(value, options.instance_seed);
+        } else if (name == "--warmup") {
+            parsed = parse_number(value, options.warmup) && 0 <= options.warmup;
+        } else if (name == "--repetitions") {
+            parsed = parse_number(value, options.repetitions) && 0 < options.repetitions;
+        } else if (name == "--timeout") {
+            parsed = parse_number(value, options.timeout) && 0 <= options.timeout;
+        } else if (name == "--exact") {
+            options.exact = value;
+        } else if (name == "--format") {
+            parsed = value == "csv" || value == "json";
+            options.json = value == "json";
+        } else if (name == "--output") {
+            options.output = value;
+        } else if (name == "--compare_reduction") {
+            parsed = value.empty();
+            options.compare_reduction = true;
+        } else if (name == "--incremental") {
+            parsed = parse_number(value, options.incremental) && 0 <= options.incremental;
+        } else {
+            argv[kept++] = argv[i];
+            continue;
+        }
+        if (!parsed) {
+            cerr << "Error: invalid value of " << name << ".\n";
+            return false;
+        }
+    }
+    argc = kept;
+    return true;
+}
+
+void solve_repeatedly(const Solver& solver, const Instance& instance, int warmup, int repetitions, Measurement& measurement) {
+    for (int i = 0; i < warmup; ++i) {
+        solver.solve(instance);
+    }
+    Solution solution;
+    ReductionStatistics reduction;
+    for (int i = 0; i < repetitions; ++i) {
+        auto start = chrono::high_resolution_clock::now();
+        solution = solver.solve(instance, &reduction);
+        measurement.times.push_back(chrono::duration_cast<chrono::nanoseconds>(chrono::high_resolution_clock::now() - start).count());
+    }
+    long long price = 0, weight = 0;
+    for (int index : solution.items) {
+        price += instance.prices[index];
+        weight += instance.weights[index];
+    }
+    measurement.price = solution.price;
+    measurement.reduced_count = reduction.reduced_count;
+    measurement.valid = price == solution.price && weight <= instance.max_weight;
+    measurement.status = RunStatus::ok;
+}
+
+/*
+Задача решается в сессии (solver_session.h) один раз без замера, затем перед каждым прогоном у updates случайных
+предметов стоимость и вес меняются до чем на 10% в обе стороны; замеряется update всех изменений вместе с resolve.
+Зерно изменений постоянное, а генератор тот же, что у задач (InstanceGenerator), поэтому прогоны разных версий
+и сборок разными компиляторами меняют задачу одинаково.
+*/
+void solve_incrementally(const Solver& solver, const Instance& instance, int warmup, int repetitions, int updates, Measurement& measurement) {
+    SolverSession session(solver, instance);
+    session.resolve();
+    InstanceGenerator random(1);
+    auto perturb = [&](int value) {
+        int spread = value / 10;
+        return value + random.uniform(-spread, spread);
+    };
+    ReductionStatistics reduction;
+    for (int i = 0; i < warmup + repetitions; ++i) {
+        vector<Item> changes(updates);
+        vector<int> items(updates);
+        for (int j = 0; j < updates; ++j) {
+            items[j] = random.uniform(0, instance.count - 1);
+            changes[j] = {max(perturb(session.instance().prices[items[j]]), 0), max(perturb(session.instance().weights[items[j]]), 1)};
+        }
+        auto start = chrono::high_resolution_clock::now();
+        for (int j = 0; j < updates; ++j) {
+            session.update(items[j], changes[j].price, changes[j].weight);
+        }
+        session.resolve(&reduction);
+        if (warmup <= i) {
+            measurement.times.push_back(chrono::duration_cast<chrono::nanoseconds>(chrono::high_resolution_clock::now() - start).count());
+        }
+    }
+    const Instance& changed = session.instance();
+    const Solution& solution = session.solution();
+    long long price = 0, weight = 0;
+    for (int index : solution.items) {
+        price += changed.prices[index];
+        weight += changed.weights[index];
+    }
+    measurement.price = solution.price;
+    measurement.reduced_count = reduction.reduced_count;
+    measurement.valid = price == solution.price && weight <= changed.max_weight;
+    measurement.status = RunStatus::ok;
+}
+
+/*
+Каждый решатель решает задачу в отдельном процессе: так пиковая память (ru_maxrss потомка) относится только к нему
+(плюс уже загруженная задача), а зависший решатель снимается по сигналу таймера и не останавливает весь набор.
+Сам набор потоков не запускает, поэтому fork безопасен и с OpenMP. Без fork (Windows) решатель работает в этом же
+процессе, без ограничения времени и без замера памяти.
+*/
+Measurement measure(const Solver& solver, const Instance& instance, int warmup, int repetitions, int timeout, int updates = 0) {
+    Measurement measurement;
+    auto solve = [&] {
+        if (updates == 0) {
+            solve_repeatedly(solver, instance, warmup, repetitions, measurement);
+        } else {
+            solve_incrementally(solver, instance, warmup, repetitions, updates, measurement);
+        }
+    };
+#if defined(_WIN32)
+    solve();
+#else
+    int channel[2];
+    if (pipe(channel) != 0) {
+        return measurement;
+    }
+    cout.flush();
+    pid_t child = fork();
+    if (child < 0) {
+        close(channel[0]);
+        close(channel[1]);
+        return measurement;
+    }
+    if (child == 0) {
+        close(channel[0]);
+        alarm(timeout);
+        solve();
+        long long header[3] = {measurement.price, measurement.valid, measurement.reduced_count};
+        bool written = write(channel[1], header, sizeof(header)) == sizeof(header);
+        size_t size = measurement.times.size() * sizeof(long long);
+        written = written && write(channel[1], measurement.times.data(), size) == static_cast<ssize_t>(size);
+        _exit(written ? 0 : 1);
+    }
+    close(channel[1]);
+    vector<char> received;
+    char buffer[1 << 12];
+    for (ssize_t size; (size = read(channel[0], buffer, sizeof(buffer))) != 0;) {
+        if (0 < size) {
+            received.insert(received.end(), buffer, buffer + size);
+        } else if (errno != EINTR) {
+            break;
+        }
+    }
+    close(channel[0]);
+    int status;
+    rusage usage{};
+    while (wait4(child, &status, 0, &usage) < 0 && errno == EINTR) {
+    }
+    measurement.peak_rss = usage.ru_maxrss;
+#if defined(__APPLE__)
+    measurement.peak_rss /= 1024; // в байтах, а не в КБ
+#endif
+    if (WIFSIGNALED(status) && WTERMSIG(status) == SIGALRM) {
+        measurement.status = RunStatus::timeout;
+    } else if (WIFEXITED(status) && WEXITSTATUS(status) == 0 && received.size() == (3 + repetitions) * sizeof(long long)) {
+        const long long* values = reinterpret_cast<const long long*>(received.data());
+        measurement.status = RunStatus::ok;
+        measurement.price = values[0];
+        measurement.valid = values[1] != 0;
+        measurement.reduced_count = static_cast<int>(values[2]);
+        measurement.times.assign(values + 3, values + 3 + repetitions);
+    }
+#endif
+    return measurement;
+}
+
+// элемент отсортированного массива с рангом ceil(percent / 100 * n)
+double percentile(const vector<long long>& sorted_times, double percent) noexcept {
+    size_t rank = static_cast<size_t>(ceil(percent / 100 * sorted_times.size()));
+    return static_cast<double>(sorted_times[max<size_t>(rank, 1) - 1]);
+}
+
+double median(const vector<long long>& sorted_times) noexcept {
+    size_t middle = sorted_times.size() / 2;
+    return sorted_times.size() % 2 == 1 ? sorted_times[middle] : (sorted_times[middle - 1] + sorted_times[middle]) / 2.0;
+}
+
+struct ReportRow {
+    InstanceFamily family;
+    int n;
+    double capacity_ratio;
+    int max_weight;
+    const char* solver;
+    bool reduction;
+    int incremental; // сколько предметов менялось перед каждым решением в сессии; 0 - решение с нуля
+    Measurement measurement;
+    bool has_exact;
+    long long exact_price;
+};
+
+class Report {
+public:
+    Report(ostream& stream, bool json) :
+        stream_(stream),
+        json_(json) {
+        if (json_) {
+            stream_ << "[\n";
+        } else {
+            stream_ << "family,n,capacity_ratio,max_weight,solver,status,repetitions,median_ms,p99_ms,min_ms,peak_rss_kb,price,valid,exact_price,gap,reduction,reduced_n,incremental\n";
+        }
+    }
+
+    Report(const Report&) = delete;
+    Report& operator=(const Report&) = delete;
+
+    ~Report() {
+        if (json_) {
+            stream_ << (rows_ == 0 ? "" : "\n") << "]\n";
+        }
+        stream_.flush();
+    }
+
+    // отставание - доля недобранной стоимости относительно точного ответа
+    void add(const ReportRow& row) {
+        const Measurement& measurement = row.measurement;
+        bool ok = measurement.status == RunStatus::ok;
+        vector<long long> sorted_times = measurement.times;
+        sort(sorted_times.begin(), sorted_times.end());
+        string null = json_ ? "null" : "";
+        auto milliseconds = [&](double nanoseconds) { return ok ? to_string(nanoseconds / 1e6) : null; };
+        string gap = null;
+        if (ok && row.has_exact) {
+            gap = to_string(row.exact_price == 0 ? 0.0 : static_cast<double>(row.exact_price - measurement.price) / row.exact_price);
+        }
+        string fields[][2] = {
+            {"family", quote(family_name(row.family))},
+            {"n", to_string(row.n)},
+            {"capacity_ratio", to_string(row.capacity_ratio)},
+            {"max_weight", to_string(row.max_weight)},
+            {"solver", quote(row.solver)},
+            {"status", quote(status_name(measurement.status))},
+            {"repetitions", to_string(measurement.times.size())},
+            {"median_ms", ok ? milliseconds(median(sorted_times)) : null},
+            {"p99_ms", ok ? milliseconds(percentile(sorted_times, 99)) : null},
+            {"min_ms", ok ? milliseconds(sorted_times.front()) : null},
+            {"peak_rss_kb", measurement.peak_rss < 0 ? null : to_string(measurement.peak_rss)},
+            {"price", ok ? to_string(measurement.price) : null},
+            {"valid", ok ? (measurement.valid ? "true" : "false") : null},
+            {"exact_price", row.has_exact ? to_string(row.exact_price) : null},
+            {"gap", gap},
+            {"reduction", row.reduction ? "true" : "false"},
+            {"reduced_n", ok ? to_string(measurement.reduced_count) : null},
+            {"incremental", to_string(row.incremental)}
+        };
+        stream_ << (json_ ? (rows_ == 0 ? "  {" : ",\n  {") : "");
+        bool first = true;
+        for (const auto& field : fields) {
+            if (json_) {
+                stream_ << (first ? "" : ", ") << '"' << field[0] << "\": " << field[1];
+            } else {
+                stream_ << (first ? "" : ",") << field[1];
+            }
+            first = false;
+        }
+        stream_ << (json_ ? "}" : "\n");
+        stream_.flush();
+        ++rows_;
+    }
+
+private:
+    ostream& stream_;
+    bool json_;
+    int rows_ = 0;
+
+    string quote(const string& text) const {
+        return json_ ? '"' + text + '"' : text;
+    }
+};
+
+/*
+Набор замеров для поиска регрессий производительности: задачи классических семейств (см. instance_generators.h)
+для всех сочетаний семейства, числа предметов и доли вместимости решаются каждым выбранным решателем
+warmup раз без замера и repetitions раз с замером. Для каждой пары "задача - решатель" выводятся медиана, 99-й
+процентиль и минимум времени, пиковая память, ответ, отставание от точного решателя (--exact) и число предметов
+после предобработки в CSV или JSON.
+При одинаковых аргументах задачи одинаковые, поэтому выводы разных версий можно сравнивать построчно.
+Аргументы командной строки:
+    --families=имя,имя,... или all - семейства задач (по умолчанию все);
+    --sizes=100,1000 - числа предметов;
+    --capacities=0.25,0.5 - вместимость как доля суммарного веса;
+    --range=1000 - наибольший вес и стоимость;
+    --instance_seed=1 - зерно генератора задач;
+    --warmup=1, --repetitions=5 - прогоны без замера и с замером;
+    --timeout=10 - секунд на все прогоны одного решателя на одной задаче, 0 - без ограничения;
+    --exact=dynamic_programming - точный решатель, от ответа которого считается отставание;
+    --format=csv или json, --output=файл (по умолчанию стандартный вывод);
+    --compare_reduction - каждый решатель замеряется с предобработкой и без нее (строки с reduction = true и false),
+    разница медиан - сэкономленное предобработкой время;
+    --incremental=k - каждый решатель замеряется еще и в сессии: изменение k предметов и повторное решение (строки
+    с incremental = k, см. solve_incrementally) против решения с нуля (incremental = 0); ответ и отставание у таких
+    строк относятся к измененной задаче, поэтому с точным ответом исходной задачи не сравниваются;
+    --solvers=имя,имя,... - решатели (по умолчанию все);
+    --config=файл и --имя=значение - параметры решателей (зерно генетических алгоритмов по умолчанию 1).
+*/
+int main(int argc, char* argv[]) {
+    SuiteOptions options;
+    vector<unique_ptr<Solver>> solvers = make_solvers();
+    vector<Solver*> selected;
+    if (!parse_suite_arguments(argc, argv, options) || !select_solvers(argc, argv, solvers, selected)) {
+        return 1;
+    }
+    for (const auto& solver : solvers) {
+        solver->set_parameter("seed", "1");
+    }
+    vector<Solver*> all_solvers;
+    for (const auto& solver : solvers) {
+        all_solvers.push_back(solver.get());
+    }
+    Solver* exact = find_solver(solvers, options.exact);
+    if (exact == nullptr) {
+        print_unknown_solver(solvers, options.exact);
+        return 1;
+    }
+    if (!parse_arguments(all_solvers, argc, argv)) {
+        return 1;
+    }
+
+    ofstream file;
+    if (!options.output.empty()) {
+        file.open(options.output);
+        if (!file.is_open()) {
+            cerr << "Error: can't open the file '" << options.output << "'.\n";
+            return 1;
+        }
+    }
+    Report report(options.output.empty() ? cout : file, options.json);
+    Instance instance;
+    for (InstanceFamily family : options.families) {
+        for (int n : options.sizes) {
+            for (double capacity_ratio : options.capacity_ratios) {
+                generate_instance(family, n, options.range, capacity_ratio, options.instance_seed, instance);
+                cerr << family_name(family) << " n=" << n << " capacity=" << capacity_ratio << ":";
+
+                // точный ответ нужен до остальных решателей; если точный решатель не выбран, он решает задачу один раз без вывода
+                // ядро (core_size) - эвристика, поэтому точный ответ считается без него, а с ядром точный решатель замеряется как остальные
+                bool exact_selected = find(selected.begin(), selected.end(), exact) != selected.end() && exact->core_size == 0;
+                int core_size = exact->core_size;
+                exact->core_size = 0;
+                Measurement exact_measurement = measure(*exact, instance, exact_selected ? options.warmup : 0,
+                    exact_selected ? options.repetitions : 1, options.timeout);
+                exact->core_size = core_size;
+                bool has_exact = exact_measurement.status == RunStatus::ok && exact_measurement.valid;
+                for (Solver* solver : selected) {
+                    Measurement measurement = solver == exact && exact_selected ? exact_measurement : measure(*solver, instance, options.warmup, options.repetitions, options.timeout);
+                    cerr << ' ' << solver->name() << (measurement.status == RunStatus::ok ? "" : string("(") + status_name(measurement.status) + ")");
+                    report.add({family, n, capacity_ratio, instance.max_weight, solver->name(), solver->reduction, 0, measurement, has_exact, exact_measurement.price});
+                    if (options.compare_reduction && solver->reduction) {
+                        solver->set_parameter("reduction", "0");
+                        measurement = measure(*solver, instance, options.warmup, options.repetitions, options.timeout);
+                        solver->set_parameter("reduction", "1");
+                        report.add({family, n, capacity_ratio, instance.max_weight, solver->name(), false, 0, measurement, has_exact, exact_measurement.price});
+                    }
+                    if (options.incremental != 0) {
+                        measurement = measure(*solver, instance, options.warmup, options.repetitions, options.timeout, options.incremental);
+                        report.add({family, n, capacity_ratio, instance.max_weight, solver->name(), solver->reduction, options.incremental, measurement, false, 0});
+                    }
+                }
+                cerr << '\n';
+            }
+        }
+    }
+    return 0;
+}
\ No newline at end of file
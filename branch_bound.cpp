@@ -2,155 +2,200 @@
 #include <fstream>
 #include <string>
 #include <vector>
-#include <queue>
 #include <algorithm>
+#include <random>
 #include <chrono>
+#include "branch_bound.h"
 
 using namespace std;
+using namespace branch_bound;
 
-struct Item {
-    int price;
-    int weight;
-};
-
-// структура состояния
-struct State {
-private:
-    double calculate_upper_boundary(int max_weight, const vector<Item>& items) noexcept {
-        if (max_weight <= weight) { // если рюкзак полон
-            return price; // то это максимальная стоимость
-        }
-
-        double upper_value = price;
-        int weight_left = max_weight - weight; // оставшийся вес (сколько еще можем набрать до переполнения)
-
-        // жадный алгоритм
-        for (int i = index + 1; i < items.size(); ++i) {
-            if (items[i].weight <= weight_left) {
-                upper_value += items[i].price; // добавляем предмет
-                weight_left -= items[i].weight; // уменьшаем оставшийся допустимый вес
-            } else {
-                double specific_price = static_cast<double>(items[i].price) / items[i].weight; // удельная стоимость
-                return upper_value + weight_left * specific_price; // добавляем "часть" предмета, исходя из удельной стоимости, и больше ничего добавить нельзя
-            }
-        }
-        return upper_value;
+#if defined(BENCHMARK)
+// случайные предметы: вес от 1 до 1000, стоимость - случайная или сильно коррелированная с весом (вес + 100), вместимость - половина суммарного веса
+vector<Item> generate_items(int n, int& max_weight, unsigned int seed, bool correlated = false) noexcept {
+    mt19937 generator(seed);
+    uniform_int_distribution<int> distribution(1, 1000);
+    vector<Item> items(n);
+    long long total_weight = 0;
+    for (auto& item : items) {
+        item.weight = distribution(generator);
+        item.price = correlated ? item.weight + 100 : distribution(generator);
+        total_weight += item.weight;
     }
-public:
-    int index; // индекс предмета
-    int price; // уже набранная стоимость
-    int weight; // уже набранный вес
-    double upper_boundary; // верхняя оценка на стоимость
+    max_weight = static_cast<int>(total_weight / 2);
+    return items;
+}
 
-    State(int max_weight, const vector<Item>& items, int state_index, int state_price, int state_weight) noexcept :
-        index(state_index),
-        price(state_price),
-        weight(state_weight),
-        upper_boundary(calculate_upper_boundary(max_weight, items)) {}
+// запускает поиск без восстановления решения и с ним, чтобы показать цену восстановления по времени и памяти
+void print_run(const string& name, int n, const Instance& instance, size_t memory_limit) {
+    SearchStatistics statistics;
+    auto start = chrono::high_resolution_clock::now();
+    Solution solution = solve<false>(instance, memory_limit, &statistics);
+    auto end = chrono::high_resolution_clock::now();
+    double seconds = chrono::duration<double>(end - start).count();
+
+    SearchStatistics reconstruct_statistics;
+    start = chrono::high_resolution_clock::now();
+    Solution reconstructed = solve<true>(instance, memory_limit, &reconstruct_statistics);
+    end = chrono::high_resolution_clock::now();
+    double reconstruct_seconds = chrono::duration<double>(end - start).count();
+
+    cout << name << '\t' << n << '\t' << memory_limit << '\t' << statistics.created_states << '\t' << statistics.depth_first_states << '\t'
+        << seconds * 1000 << '\t' << static_cast<long long>(statistics.created_states / seconds) << '\t'
+        << statistics.peak_queue_size << '\t' << statistics.peak_memory << '\t'
+        << reconstruct_seconds * 1000 << '\t' << (reconstruct_seconds / seconds - 1) * 100 << "%\t" << reconstruct_statistics.decisions_memory << '\t'
+        << solution.price << '\t' << (reconstructed.price == solution.price ? "yes" : "no") << '\t' << reconstructed.items.size() << '\n';
+}
 
-    bool operator<(const State& rhs) const noexcept {
-        return upper_boundary < rhs.upper_boundary;
+// пропускная способность (число созданных состояний в секунду) и память очереди в зависимости от n и ограничения памяти
+void benchmark() {
+    cout << "instance\tn\tmemory limit\tstates\tdepth-first states\tmilliseconds\tstates/sec\tpeak queue\tpeak bytes\t"
+        << "milliseconds with items\ttime overhead\tdecision bytes\tbest price\tsame price with items\titems taken\n";
+    for (int n : {1000, 2000, 5000, 10000, 20000, 50000}) {
+        int max_weight;
+        vector<Item> items = generate_items(n, max_weight, n);
+        Instance instance;
+        prepare_instance(max_weight, items, instance);
+        print_run("uncorrelated", n, instance, MEMORY_LIMIT);
     }
-};
-
-int solve(int max_weight, const vector<Item>& items) noexcept {
-    vector<Item> sorted_items = items;
-    sort(sorted_items.begin(), sorted_items.end(), [](const Item& lhs, const Item& rhs) {
-        double lhs_specific_price = static_cast<double>(lhs.price) / lhs.weight; // удельная стоимость lhs
-        double rhs_specific_price = static_cast<double>(rhs.price) / rhs.weight; // удельная стоимость rhs
-        return rhs_specific_price < lhs_specific_price; // сортируем по убыванию удельной стоимости
-    });
-
-    auto create_state = [&](int index, int price, int weight) {
-        return State(max_weight, sorted_items, index, price, weight);
-    };
-
-    priority_queue<State> queue;
-    State root = create_state(-1, 0, 0);
-    queue.push(root);
-    int best_price = 0;
-    while (!queue.empty()) {
-        State current_state = queue.top();
-        queue.pop();
-
-        if (current_state.upper_boundary < best_price) {
-            continue; // точно не наберем цену лучше
+    for (int n : {40, 60, 80}) {
+        int max_weight;
+        vector<Item> items = generate_items(n, max_weight, n, true);
+        Instance instance;
+        prepare_instance(max_weight, items, instance);
+        for (size_t memory_limit : {MEMORY_LIMIT, 1ull << 20}) {
+            print_run("correlated", n, instance, memory_limit);
         }
+    }
 
-        if (current_state.index == items.size() - 1) { // если обработали последний предмет
-            best_price = max(best_price, current_state.price); // обновляем лучшую цену
-            continue;
+    // начальный рекорд и ныряния: насколько меньше состояний создается и насколько меньше пиковая очередь
+    cout << "\ninstance\tn\twarm start\tdive interval\tinitial price\tstates\tpeak queue\tdives\tdive improvements\tmilliseconds\tbest price\n";
+    for (auto [n, correlated] : {pair(10000, false), pair(50000, false), pair(60, true), pair(80, true)}) {
+        int max_weight;
+        vector<Item> items = generate_items(n, max_weight, n, correlated);
+        Instance instance;
+        prepare_instance(max_weight, items, instance);
+        for (SearchOptions options : {SearchOptions{false, 0}, SearchOptions{true, 0}, SearchOptions{false, DIVE_INTERVAL}, SearchOptions{true, DIVE_INTERVAL}}) {
+            SearchStatistics statistics;
+            auto start = chrono::high_resolution_clock::now();
+            Solution solution = solve(instance, MEMORY_LIMIT, &statistics, nullptr, nullptr, options);
+            auto end = chrono::high_resolution_clock::now();
+            cout << (correlated ? "correlated" : "uncorrelated") << '\t' << n << '\t' << options.warm_start << '\t' << options.dive_interval << '\t'
+                << statistics.initial_price << '\t' << statistics.created_states << '\t' << statistics.peak_queue_size << '\t'
+                << statistics.dives << '\t' << statistics.dive_improvements << '\t'
+                << chrono::duration<double, milli>(end - start).count() << '\t' << solution.price << '\n';
         }
+    }
 
-        int next_index = current_state.index + 1;
-        State without_next_item = create_state(next_index, current_state.price, current_state.weight);
-        State with_next_item = create_state(next_index, current_state.price + items[next_index].price, current_state.weight + items[next_index].weight);
-
-        if (best_price <= without_next_item.upper_boundary) {
-            queue.push(without_next_item);
+    // порядок обхода без начального рекорда: состояния, память и время до первого и до оптимального рекорда
+    cout << "\ninstance\tn\tstrategy\tstates\tpeak queue\tpeak stack\tpeak bytes\tfirst incumbent ms\tbest incumbent ms\tmilliseconds\tbest price\n";
+    for (auto [n, correlated] : {pair(10000, false), pair(50000, false), pair(60, true), pair(80, true)}) {
+        int max_weight;
+        vector<Item> items = generate_items(n, max_weight, n, correlated);
+        Instance instance;
+        prepare_instance(max_weight, items, instance);
+        for (SearchStrategy strategy : SEARCH_STRATEGIES) {
+            SearchStatistics statistics;
+            auto start = chrono::high_resolution_clock::now();
+            Solution solution = solve(instance, MEMORY_LIMIT, &statistics, nullptr, nullptr, SearchOptions{false, DIVE_INTERVAL, strategy});
+            auto end = chrono::high_resolution_clock::now();
+            cout << (correlated ? "correlated" : "uncorrelated") << '\t' << n << '\t' << strategy_name(strategy) << '\t' << statistics.created_states << '\t'
+                << statistics.peak_queue_size << '\t' << statistics.peak_stack_size << '\t' << statistics.peak_memory + statistics.decisions_memory << '\t'
+                << statistics.first_incumbent_seconds * 1000 << '\t' << statistics.best_incumbent_seconds * 1000 << '\t'
+                << chrono::duration<double, milli>(end - start).count() << '\t' << solution.price << '\n';
         }
+    }
 
-        if (best_price <= with_next_item.upper_boundary && with_next_item.weight <= max_weight) {
-            queue.push(with_next_item);
+    // оценка Данцига против оценки Мартелло - Тота U2: сколько состояний отсекает более сильная оценка и окупается ли она по времени
+    cout << "\ninstance\tn\tbound\tstates\tpeak queue\tmilliseconds\tstates/sec\tbest price\n";
+    for (auto [n, correlated] : {pair(10000, false), pair(50000, false), pair(60, true), pair(80, true)}) {
+        int max_weight;
+        vector<Item> items = generate_items(n, max_weight, n, correlated);
+        Instance instance;
+        prepare_instance(max_weight, items, instance);
+        for (bool martello_toth : {false, true}) {
+            SearchOptions options;
+            options.martello_toth = martello_toth;
+            SearchStatistics statistics;
+            auto start = chrono::high_resolution_clock::now();
+            Solution solution = solve<false>(instance, MEMORY_LIMIT, &statistics, nullptr, nullptr, options);
+            double seconds = chrono::duration<double>(chrono::high_resolution_clock::now() - start).count();
+            cout << (correlated ? "correlated" : "uncorrelated") << '\t' << n << '\t' << (martello_toth ? "martello_toth" : "dantzig") << '\t'
+                << statistics.created_states << '\t' << statistics.peak_queue_size << '\t' << seconds * 1000 << '\t'
+                << static_cast<long long>(statistics.created_states / seconds) << '\t' << solution.price << '\n';
         }
     }
-    return best_price;
-}
 
-vector<Item> manual_input(int& n, int& max_weight) noexcept {
-    cout << "Input number of items: ";
-    cin >> n;
-    cout << "Input max backpack weight: ";
-    cin >> max_weight;
-    cout << "Input n pairs: price - weight\n";
-    vector<Item> items(n);
-    for (int i = 0; i < n; ++i) {
-        cin >> items[i].price >> items[i].weight;
+    // масштабирование параллельного поиска от 1 до N потоков
+    int max_threads = max(4, static_cast<int>(thread::hardware_concurrency()));
+    cout << "\ninstance\tn\tthreads\tstates\tmilliseconds\tspeedup\tbest price\tmatches solve\n";
+    for (auto [n, correlated] : {pair(50000, false), pair(80, true)}) {
+        int max_weight;
+        vector<Item> items = generate_items(n, max_weight, n, correlated);
+        Instance instance;
+        prepare_instance(max_weight, items, instance);
+        long long serial_price = solve(instance).price;
+        double serial_seconds = 0;
+        for (int threads_count = 1; threads_count <= max_threads; threads_count *= 2) {
+            SearchStatistics statistics;
+            auto start = chrono::high_resolution_clock::now();
+            long long best_price = parallel_solve(instance, threads_count, MEMORY_LIMIT, &statistics).price;
+            auto end = chrono::high_resolution_clock::now();
+            double seconds = chrono::duration<double>(end - start).count();
+            if (threads_count == 1) {
+                serial_seconds = seconds;
+            }
+            cout << (correlated ? "correlated" : "uncorrelated") << '\t' << n << '\t' << threads_count << '\t' << statistics.created_states << '\t'
+                << seconds * 1000 << '\t' << serial_seconds / seconds << '\t' << best_price << '\t' << (best_price == serial_price ? "yes" : "no") << '\n';
+        }
     }
-    return items;
 }
+#endif
 
-vector<Item> file_input(int& n, int& max_weight, const string& filename) {
-    ifstream file(filename);
-    if (!file.is_open()) {
-        cerr << "Error: can't open the file '" << filename << "'.\n";
-        return {};
+// Аргументы командной строки: --config=файл и --time_limit=мс (срок решения, по истечении выводится лучший найденный ответ)
+// --extended - задача с несколькими ограничениями, кратностями или классами (формат - в extended_instance.h)
+int main(int argc, char* argv[]) {
+#if defined(BENCHMARK)
+    benchmark();
+    return 0;
+#endif
+    BranchAndBoundSolver solver;
+    BatchOptions batch;
+    StatisticsOptions statistics;
+    bool extended = false;
+    if (!parse_batch_arguments(argc, argv, batch) || !parse_statistics_arguments(argc, argv, statistics) || !parse_extended_arguments(argc, argv, extended)
+        || !parse_arguments({&solver}, argc, argv)) {
+        return 1;
     }
-
-    file >> n >> max_weight;
-    vector<Item> items(n);
-    for (int i = 0; i < n; ++i) {
-        file >> items[i].price >> items[i].weight;
+    if (extended) {
+        return run_extended(solver, [](const ExtendedProblem& problem, Solution& solution, SolveControl& control) {
+            solution = solve_extended(problem, nullptr, &control);
+            return true;
+        });
     }
-    return items;
-}
-
-vector<Item> input_data(int& n, int& max_weight) {
-    string filename;
-    cout << "Enter input filename or press Enter to manually input data: ";
-    getline(cin, filename);
-    if (filename.empty()) {
-        return manual_input(n, max_weight);
+    Instrumentation instrumentation;
+    StatisticsReporter reporter(instrumentation, statistics); // выводит статистику, только если она запрошена
+    if (statistics.enabled) {
+        solver.instrumentation = &instrumentation;
     }
-    return file_input(n, max_weight, filename);
-}
-
-int main() {
-    int n, max_weight;
-    vector<Item> items = input_data(n, max_weight);
+    if (batch.source != BatchSource::none) {
+        solver.threads_count = max(1, solver.threads_count / batch_workers_count(batch)); // потоки поиска (THREADS_COUNT или --threads_count) делятся между потоками решения
+        return run_batch(batch, solver);
+    }
+    Instance instance;
+    if (!input_data(instance)) {
+        return 1;
+    }
+    cancel_on_interrupt(solver);
     auto start = chrono::high_resolution_clock::now();
-    int best_price = solve(max_weight, items);
+    ReductionStatistics reduction;
+    Solution solution = solver.solve(instance, &reduction);
     auto end = chrono::high_resolution_clock::now();
-    auto time_spent = end - start;
-    cout << "Maximum price that can be taken: " << best_price << '\n';
-    cout << "Time spent:\n";
-    cout << "t = " << time_spent.count() << " nanoseconds\n";
-    cout << "t ~ " << chrono::duration_cast<chrono::milliseconds>(time_spent).count() << " milliseconds\n";
-    cout << "t ~ " << chrono::duration_cast<chrono::seconds>(time_spent).count() << " seconds\n";
-#if defined(NDEBUG)
-    std::cout << "Press Enter to exit...";
-    std::cin.ignore();
-    std::cin.get();
-#endif
+    reporter.stop();
+    if (solver.reduction) {
+        print_reduction(reduction);
+    }
+    print_solution(solution, end - start);
+    wait_for_exit();
     return 0;
 }
\ No newline at end of file
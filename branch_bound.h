@@ -0,0 +1,1051 @@
+#pragma once
+
+#include <vector>
+#include <algorithm>
+#include <memory>
+#include <climits>
+#include <atomic>
+#include <mutex>
+#include <thread>
+#include <chrono>
+#include <string>
+#include "knapsack.h"
+#include "greedy.h"
+#include "extended_instance.h"
+
+#define MEMORY_LIMIT (1ull << 30) // ограничение памяти на очередь состояний в байтах
+#define HEAP_ARITY 4 // число потомков узла в куче
+#define POOL_BLOCK_SIZE (1 << 16) // число состояний в одном блоке пула
+#define STOP_POLL_STATES 4096 // через сколько раскрытых состояний поток проверяет срок решения
+#define WARM_START 1 // 1 - начальный рекорд из greedy::local_search_solve, 0 - поиск начинается с рекорда 0
+#define DIVE_INTERVAL 1024 // через сколько раскрытых из очереди состояний поток ныряет от лучшего состояния (0 - без ныряний)
+#define MARTELLO_TOTH_BOUND 0 // 1 - оценка Мартелло - Тота U2 вместо оценки Данцига (см. UpperBoundaryEngine)
+#define SEARCH_STRATEGY best_first // порядок обхода дерева: best_first, depth_first или hybrid (см. SearchStrategy)
+#if !defined(THREADS_COUNT)
+#define THREADS_COUNT 1 // число потоков поиска (1 - последовательный поиск)
+#endif
+
+namespace branch_bound {
+
+/*
+Движок верхних оценок.
+Предметы отсортированы по убыванию удельной стоимости, поэтому жадное заполнение с позиции first
+берет подряд предметы first, first + 1, ... до первого не поместившегося (критического) предмета.
+По префиксным суммам весов критический предмет ищется бинпоиском, а стоимость взятых предметов считается за O(1).
+Поиск начинается с критического предмета родителя (у потомков он не может оказаться левее),
+поэтому экспоненциальный поиск от подсказки в среднем работает за O(1).
+Оценки считаются в 64-битных целых без деления с плавающей точкой и округляются вниз: стоимости целые, поэтому
+состояние с оценкой, не большей рекорда, отсекается точно.
+Оценка Данцига добирает "часть" критического предмета c. Оценка Мартелло - Тота U2 = max(U0, U1) не больше ее:
+U0 - без предмета c, остаток вместимости заполняется по удельной стоимости предмета c + 1;
+U1 - с предметом c, недостающий вес освобождается по удельной стоимости предмета c - 1 (худшего из взятых до c).
+U2 дороже на одно деление, но отсекает больше состояний, особенно когда удельные стоимости соседних предметов различаются.
+*/
+struct UpperBoundaryEngine {
+    int max_weight;
+    const int* prices; // стоимости отсортированных предметов
+    const int* weights; // веса отсортированных предметов
+    int count;
+    std::vector<long long> prefix_weight; // prefix_weight[i] - суммарный вес первых i предметов
+    std::vector<long long> prefix_price; // prefix_price[i] - суммарная стоимость первых i предметов
+    bool martello_toth; // оценка U2 вместо оценки Данцига
+
+    UpperBoundaryEngine(const Instance& instance, bool martello_toth_bound) noexcept :
+        max_weight(instance.max_weight),
+        prices(instance.sorted_prices.data()),
+        weights(instance.sorted_weights.data()),
+        count(instance.count),
+        prefix_weight(instance.count + 1, 0),
+        prefix_price(instance.count + 1, 0),
+        martello_toth(martello_toth_bound) {
+        for (int i = 0; i < count; ++i) {
+            prefix_weight[i + 1] = prefix_weight[i] + weights[i];
+            prefix_price[i + 1] = prefix_price[i] + prices[i];
+        }
+    }
+
+    int size() const noexcept {
+        return count;
+    }
+
+    // индекс критического предмета при жадном заполнении weight_left с позиции first (size(), если помещаются все)
+    // hint - индекс, левее которого критический предмет точно не находится
+    int critical_index(int first, int weight_left, int hint) const noexcept {
+        long long limit = prefix_weight[first] + weight_left; // жадно берем предметы, пока префиксная сумма весов не превышает limit
+        int low = std::max(first, hint); // prefix_weight[low] <= limit
+        int step = 1;
+        int high = low + 1;
+        while (high <= size() && prefix_weight[high] <= limit) { // экспоненциальный поиск от подсказки
+            low = high;
+            step *= 2;
+            high = low + step;
+        }
+        high = std::min(high, size() + 1);
+        return static_cast<int>(std::upper_bound(prefix_weight.begin() + low + 1, prefix_weight.begin() + high, limit) - prefix_weight.begin()) - 1;
+    }
+
+    // верхняя оценка стоимости (ее целая часть, так как стоимости целые), если предметы с индексами < first уже рассмотрены, а critical - критический предмет
+    long long upper_boundary(int first, long long price, int weight, int critical) const noexcept {
+        long long upper_value = price + prefix_price[critical] - prefix_price[first]; // предметы до критического берем целиком
+        if (critical < size()) {
+            long long critical_weight_left = max_weight - weight - (prefix_weight[critical] - prefix_weight[first]); // сколько веса осталось под критический предмет
+            if (!martello_toth) {
+                upper_value += critical_weight_left * prices[critical] / weights[critical]; // добавляем "часть" критического предмета, исходя из удельной стоимости
+            } else {
+                long long without_critical = critical + 1 < size() ? critical_weight_left * prices[critical + 1] / weights[critical + 1] : 0; // U0
+                long long with_critical = LLONG_MIN; // U1; если свободных предметов до критического нет, взять его нельзя
+                if (first < critical) {
+                    long long missing_weight = weights[critical] - critical_weight_left;
+                    with_critical = prices[critical] - (missing_weight * prices[critical - 1] + weights[critical - 1] - 1) / weights[critical - 1];
+                }
+                upper_value += std::max(without_critical, with_critical);
+            }
+        }
+        return upper_value;
+    }
+};
+
+// упакованное состояние (24 байта), критический предмет пересчитывается при раскрытии;
+// стоимости 64-битные: сумма 32-битных стоимостей предметов может не поместиться в int
+struct Node {
+    long long price; // уже набранная стоимость
+    long long upper_boundary; // верхняя оценка на стоимость
+    int id; // при восстановлении решения - запись решения (Decision), иначе - индекс предмета
+    int weight; // уже набранный вес
+};
+static_assert(sizeof(Node) == 24);
+
+// блок пула выровнен по кэш-линии: 4 потомка узла кучи (96 байт) всегда лежат в двух соседних кэш-линиях
+struct alignas(64) NodeBlock {
+    Node nodes[POOL_BLOCK_SIZE];
+};
+
+// пул узлов: память выделяется блоками фиксированного размера, при росте узлы не копируются (в отличие от vector)
+struct NodePool {
+    std::vector<std::unique_ptr<NodeBlock>> blocks;
+
+    Node& operator[](size_t i) noexcept {
+        return blocks[i / POOL_BLOCK_SIZE]->nodes[i % POOL_BLOCK_SIZE];
+    }
+
+    void reserve(size_t count) noexcept { // выделяет блоки, чтобы узлы [0, count) существовали
+        while (blocks.size() * POOL_BLOCK_SIZE < count) {
+            blocks.emplace_back(new NodeBlock); // без обнуления: узел пишется до первого чтения
+        }
+    }
+
+    size_t allocated_bytes() const noexcept {
+        return blocks.size() * sizeof(NodeBlock);
+    }
+};
+
+/*
+d-ичная куча (максимум по upper_boundary) поверх пула.
+Элемент кучи k хранится в pool[k + HEAP_ARITY - 1], тогда потомки элемента k лежат в pool[HEAP_ARITY * (k + 1) + j], j < HEAP_ARITY,
+то есть выровнены на HEAP_ARITY узлов и при HEAP_ARITY = 4 сравниваются за обращение к двум соседним кэш-линиям.
+*/
+struct NodeHeap {
+    static constexpr size_t offset = HEAP_ARITY - 1;
+
+    NodePool pool;
+    size_t count; // число узлов в куче
+    size_t capacity; // максимальное число узлов в куче
+
+    explicit NodeHeap(size_t max_nodes) noexcept :
+        count(0),
+        capacity(max_nodes) {}
+
+    bool empty() const noexcept {
+        return count == 0;
+    }
+
+    bool full() const noexcept {
+        return count == capacity;
+    }
+
+    const Node& top() noexcept {
+        return pool[offset];
+    }
+
+    void push(const Node& node) noexcept {
+        size_t i = count++;
+        pool.reserve(i + offset + 1);
+        while (i > 0) { // просеивание вверх
+            size_t parent = (i - 1) / HEAP_ARITY;
+            if (node.upper_boundary <= pool[parent + offset].upper_boundary) {
+                break;
+            }
+            pool[i + offset] = pool[parent + offset];
+            i = parent;
+        }
+        pool[i + offset] = node;
+    }
+
+    Node pop() noexcept {
+        Node top = pool[offset];
+        Node last = pool[--count + offset];
+        size_t i = 0;
+        while (true) { // просеивание вниз
+            size_t first_child = i * HEAP_ARITY + 1;
+            if (count <= first_child) {
+                break;
+            }
+            size_t last_child = std::min(first_child + HEAP_ARITY, count);
+            size_t best_child = first_child;
+            for (size_t child = first_child + 1; child < last_child; ++child) {
+                if (pool[best_child + offset].upper_boundary < pool[child + offset].upper_boundary) {
+                    best_child = child;
+                }
+            }
+            if (pool[best_child + offset].upper_boundary <= last.upper_boundary) {
+                break;
+            }
+            pool[i + offset] = pool[best_child + offset];
+            i = best_child;
+        }
+        pool[i + offset] = last;
+        return top;
+    }
+};
+
+struct SearchStatistics {
+    long long created_states = 0; // число созданных состояний
+    long long depth_first_states = 0; // из них рассмотрено поиском в глубину после достижения ограничения памяти
+    size_t peak_queue_size = 0; // максимальный размер очереди
+    size_t peak_memory = 0; // память под очередь, байт
+    size_t decisions_memory = 0; // память под записи решений для восстановления ответа, байт
+    size_t peak_stack_size = 0; // максимальный размер стека поиска в глубину
+    long long initial_price = 0; // начальный рекорд (см. SearchOptions)
+    long long dives = 0; // число ныряний
+    long long dive_improvements = 0; // из них улучшили рекорд
+    double first_incumbent_seconds = -1; // от начала решения до первого ненулевого рекорда (-1 - рекорда не было)
+    double best_incumbent_seconds = -1; // до последнего улучшения рекорда; после полного поиска - до оптимального ответа
+
+    void merge(const SearchStatistics& other) noexcept { // суммирует статистику потоков
+        created_states += other.created_states;
+        depth_first_states += other.depth_first_states;
+        peak_queue_size += other.peak_queue_size;
+        peak_memory += other.peak_memory;
+        decisions_memory += other.decisions_memory;
+        peak_stack_size += other.peak_stack_size;
+        initial_price = std::max(initial_price, other.initial_price);
+        dives += other.dives;
+        dive_improvements += other.dive_improvements;
+    }
+};
+
+/*
+Способы рано получить хороший рекорд: чем он ближе к оптимуму, тем больше состояний отсекается и тем меньше очередь.
+warm_start - рекорд до начала поиска из greedy::local_search_solve (жадный ответ, лучший одиночный предмет, 1-swap и 2-swap).
+Решения теплого старта (SolveControl::seeds, например прошлый ответ сессии SolverSession) становятся рекордом, если они лучше.
+dive_interval - каждые dive_interval раскрытых из очереди состояний поток жадно достраивает только что взятое из очереди
+(лучшее по оценке) состояние до листа: поиск "лучший-первым" сам доходит до листьев поздно, а ныряние дает решения по пути.
+*/
+/*
+Порядок обхода дерева.
+best_first - очередь по верхней оценке: раскрывается меньше всего состояний, но до листьев поиск доходит поздно,
+а очередь растет экспоненциально (до memory_limit, дальше поддеревья обходятся в глубину);
+depth_first - только стек (не больше n + 1 состояний): память O(n), листья с первого спуска, зато раскрывается
+больше состояний, пока рекорд далек от оптимума; только последовательный поиск;
+hybrid - поиск в глубину до первого улучшения рекорда, затем оставшиеся в стеке состояния уходят в очередь и поиск
+продолжается лучшим-первым под тем же memory_limit.
+*/
+enum class SearchStrategy {
+    best_first,
+    depth_first,
+    hybrid
+};
+
+constexpr SearchStrategy SEARCH_STRATEGIES[] = {
+    SearchStrategy::best_first,
+    SearchStrategy::depth_first,
+    SearchStrategy::hybrid
+};
+
+inline const char* strategy_name(SearchStrategy strategy) noexcept {
+    switch (strategy) {
+    case SearchStrategy::best_first:
+        return "best_first";
+    case SearchStrategy::depth_first:
+        return "depth_first";
+    case SearchStrategy::hybrid:
+        return "hybrid";
+    }
+    return "";
+}
+
+inline bool parse_strategy(const std::string& name, SearchStrategy& strategy) noexcept {
+    for (SearchStrategy candidate : SEARCH_STRATEGIES) {
+        if (name == strategy_name(candidate)) {
+            strategy = candidate;
+            return true;
+        }
+    }
+    return false;
+}
+
+struct SearchOptions {
+    bool warm_start = WARM_START;
+    int dive_interval = DIVE_INTERVAL;
+    SearchStrategy strategy = SearchStrategy::SEARCH_STRATEGY;
+    bool martello_toth = MARTELLO_TOTH_BOUND; // оценка U2 вместо оценки Данцига (см. UpperBoundaryEngine)
+};
+
+/*
+Запись решения: какой предмет рассмотрен и взят ли он. Записи образуют дерево с общими родителями,
+поэтому путь от состояния до корня задает взятые предметы, а память растет только на одну запись на состояние.
+Запись освобождается, когда на нее не ссылаются ни состояние, ни записи потомков.
+*/
+struct Decision {
+    int parent; // запись родителя, -1 у корня
+    int index : 31; // индекс рассмотренного предмета, -1 у корня
+    bool taken : 1; // взят ли предмет
+    int references; // число ссылок: состояние с этой записью и записи потомков; меняется только через std::atomic_ref
+};
+static_assert(sizeof(Decision) == 12);
+
+// пул записей решений, общий для всех потоков: освобожденные записи попадают в список освободившего их потока.
+// Таблица блоков двухуровневая: сегменты таблицы выделяются по мере роста пула, поэтому маленькая задача
+// не платит за таблицу на все INT_MAX записей (важно в пакетном режиме, где пул создается на каждую задачу)
+struct DecisionPool {
+    static constexpr int segment_size = 64; // блоков в сегменте таблицы
+    static constexpr int max_segments = (INT_MAX / POOL_BLOCK_SIZE + 1 + segment_size - 1) / segment_size;
+
+    using Segment = std::atomic<Decision*>[segment_size];
+
+    // сегменты и блоки не перевыделяются, поэтому таблицу можно читать без блокировок
+    std::atomic<std::atomic<Decision*>*> segments[max_segments];
+    std::atomic<int> allocated; // число выделенных записей
+    std::mutex lock; // защищает выделение новых блоков и сегментов
+
+    DecisionPool() noexcept :
+        allocated(0) {
+        for (auto& segment : segments) {
+            segment.store(nullptr, std::memory_order_relaxed);
+        }
+    }
+
+    ~DecisionPool() {
+        for (auto& segment : segments) {
+            std::atomic<Decision*>* blocks = segment.load();
+            if (blocks == nullptr) {
+                continue;
+            }
+            for (int i = 0; i < segment_size; ++i) {
+                delete[] blocks[i].load();
+            }
+            delete[] blocks;
+        }
+    }
+
+    Decision& operator[](int id) noexcept {
+        int block = id / POOL_BLOCK_SIZE;
+        std::atomic<Decision*>* blocks = segments[block / segment_size].load(std::memory_order_relaxed);
+        return blocks[block % segment_size].load(std::memory_order_relaxed)[id % POOL_BLOCK_SIZE];
+    }
+
+    int allocate(std::vector<int>& free_decisions) noexcept {
+        if (!free_decisions.empty()) {
+            int id = free_decisions.back();
+            free_decisions.pop_back();
+            return id;
+        }
+        int id = allocated.fetch_add(1, std::memory_order_relaxed);
+        int block = id / POOL_BLOCK_SIZE;
+        std::atomic<std::atomic<Decision*>*>& segment = segments[block / segment_size];
+        std::atomic<Decision*>* blocks = segment.load(std::memory_order_acquire);
+        if (blocks == nullptr || blocks[block % segment_size].load(std::memory_order_acquire) == nullptr) {
+            std::lock_guard<std::mutex> guard(lock);
+            blocks = segment.load(std::memory_order_relaxed);
+            if (blocks == nullptr) {
+                blocks = new Segment();
+                segment.store(blocks, std::memory_order_release);
+            }
+            if (blocks[block % segment_size].load(std::memory_order_relaxed) == nullptr) {
+                blocks[block % segment_size].store(new Decision[POOL_BLOCK_SIZE], std::memory_order_release);
+            }
+        }
+        return id;
+    }
+
+    size_t allocated_bytes() const noexcept {
+        size_t blocks_count = (static_cast<size_t>(allocated.load()) + POOL_BLOCK_SIZE - 1) / POOL_BLOCK_SIZE;
+        return blocks_count * POOL_BLOCK_SIZE * sizeof(Decision);
+    }
+};
+
+// данные потока поиска
+struct SearchContext {
+    SearchStatistics statistics;
+    ThreadProbe probe; // счетчики инструментирования (см. instrumentation.h)
+    StopPoller stop; // срок и отмена решения
+    std::vector<Node> stack; // стек поиска в глубину; после остановки в нем остаются непросмотренные состояния
+    std::vector<int> free_decisions; // освобожденные потоком записи решений
+    std::vector<int> dive_items; // предметы (позиции в instance.order), взятые при последнем нырянии
+    int states_until_dive = 0; // сколько состояний осталось раскрыть до следующего ныряния
+    int states_until_import = 0; // сколько состояний осталось до следующей проверки общего рекорда (import_shared)
+    long long shared_version = 0; // версия общего рекорда, которую поток уже видел
+
+    SearchContext(size_t stack_capacity, Instrumentation* instrumentation, SolveControl* control) :
+        probe(instrumentation),
+        stop(control, STOP_POLL_STATES) {
+        stack.reserve(stack_capacity);
+    }
+};
+
+/*
+Общая часть последовательного и параллельного поиска: создание и раскрытие состояний, поиск в глубину.
+Лучшая найденная цена (рекорд) атомарна, чтобы все потоки отсекали состояния по лучшему известному решению.
+В последовательном поиске атомарные операции с memory_order_relaxed ничего не стоят.
+При reconstruct = true каждое состояние в очереди или стеке ссылается на запись решения, а при улучшении рекорда
+по цепочке записей собирается список взятых предметов.
+*/
+template <bool reconstruct>
+struct BranchAndBound {
+    int max_weight;
+    const Instance& instance; // предметы отсортированы при подготовке задачи: instance.order, instance.sorted_prices, instance.sorted_weights
+    UpperBoundaryEngine engine;
+    int last_index;
+    std::atomic<long long> best_price;
+    DecisionPool decisions;
+    std::mutex solution_lock; // защищает solution
+    Solution solution; // лучшее найденное решение
+    size_t memory_limit; // ограничение памяти на очередь и записи решений, байт
+    SolveControl* control; // получает каждое улучшенное решение; может быть nullptr
+    int dive_interval; // см. SearchOptions
+    long long initial_price; // рекорд до начала поиска
+    std::chrono::steady_clock::time_point start_time; // начало решения, от него считается время до рекордов
+    double first_incumbent_seconds; // см. SearchStatistics; пишутся под solution_lock
+    double best_incumbent_seconds;
+
+    BranchAndBound(const Instance& search_instance, size_t search_memory_limit, SolveControl* search_control, const SearchOptions& options) noexcept :
+        max_weight(search_instance.max_weight),
+        instance(search_instance),
+        engine(search_instance, options.martello_toth),
+        last_index(search_instance.count - 1),
+        best_price(0),
+        solution{0, {}},
+        memory_limit(search_memory_limit),
+        control(search_control),
+        dive_interval(options.dive_interval),
+        initial_price(0),
+        start_time(std::chrono::steady_clock::now()),
+        first_incumbent_seconds(-1),
+        best_incumbent_seconds(-1) {
+        if (options.warm_start) {
+            solution = greedy::local_search_solve(search_instance);
+            solution.upper_bound = -1;
+        }
+        if (control != nullptr) {
+            for (const std::vector<int>& seed : control->seeds()) { // решения теплого старта уже допустимы
+                long long price = 0;
+                for (int item : seed) {
+                    price += search_instance.prices[item];
+                }
+                if (solution.price < price) {
+                    solution = {price, seed};
+                }
+            }
+        }
+        if constexpr (!reconstruct) {
+            solution.items.clear();
+        }
+        initial_price = solution.price;
+        best_price.store(initial_price, std::memory_order_relaxed);
+        if (0 < initial_price) {
+            mark_incumbent_time();
+            if (control != nullptr) {
+                control->publish(solution);
+            }
+        }
+    }
+
+    void mark_incumbent_time() noexcept {
+        best_incumbent_seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start_time).count();
+        if (first_incumbent_seconds < 0) {
+            first_incumbent_seconds = best_incumbent_seconds;
+        }
+    }
+
+    void write_times(SearchStatistics& statistics) noexcept {
+        std::lock_guard<std::mutex> guard(solution_lock);
+        statistics.initial_price = initial_price;
+        statistics.first_incumbent_seconds = first_incumbent_seconds;
+        statistics.best_incumbent_seconds = best_incumbent_seconds;
+    }
+
+    long long incumbent() const noexcept {
+        return best_price.load(std::memory_order_relaxed);
+    }
+
+    bool update_incumbent(long long price) noexcept { // true, если рекорд улучшен
+        long long current = incumbent();
+        while (current < price) {
+            if (best_price.compare_exchange_weak(current, price, std::memory_order_relaxed)) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    /*
+    Рекорд других решателей той же задачи (SolveControl::shared, см. portfolio.h) отсекает состояния так же, как свой.
+    Номер версии читается раз в STOP_POLL_STATES состояний, решение копируется, только если версия сменилась;
+    оно становится ответом поиска, поэтому ответ никогда не хуже общего рекорда.
+    */
+    void import_shared(SearchContext& context) noexcept {
+        if (control == nullptr || control->shared() == nullptr || 0 < --context.states_until_import) {
+            return;
+        }
+        context.states_until_import = STOP_POLL_STATES;
+        const SharedIncumbent& shared = *control->shared();
+        long long version = shared.version();
+        if (version == context.shared_version) {
+            return;
+        }
+        context.shared_version = version;
+        if (shared.price() <= incumbent()) {
+            return;
+        }
+        Solution best = shared.best();
+        update_incumbent(best.price);
+        std::lock_guard<std::mutex> guard(solution_lock);
+        if (solution.price < best.price) {
+            solution = {best.price, reconstruct ? std::move(best.items) : std::vector<int>()};
+        }
+    }
+
+    // после исчерпания памяти новые поддеревья обходятся в глубину; queued_states - число состояний во всех очередях
+    bool memory_exhausted(size_t queued_states) const noexcept {
+        size_t used = queued_states * sizeof(Node);
+        if constexpr (reconstruct) {
+            used += decisions.allocated_bytes();
+        }
+        return memory_limit <= used;
+    }
+
+    int index_of(const Node& node) noexcept {
+        if constexpr (reconstruct) {
+            return decisions[node.id].index;
+        }
+        return node.id;
+    }
+
+    // запись решения для потомка, в котором рассмотрен предмет index
+    int child_id(const Node& parent, int index, bool taken, SearchContext& context) noexcept {
+        if constexpr (reconstruct) {
+            int id = decisions.allocate(context.free_decisions);
+            Decision& decision = decisions[id];
+            decision.parent = parent.id;
+            decision.index = index;
+            decision.taken = taken;
+            std::atomic_ref<int>(decision.references).store(1, std::memory_order_relaxed);
+            std::atomic_ref<int>(decisions[parent.id].references).fetch_add(1, std::memory_order_relaxed);
+            return id;
+        }
+        return index;
+    }
+
+    // состояние больше не нужно: освобождаем его запись и записи предков, на которые больше никто не ссылается
+    void release(const Node& node, SearchContext& context) noexcept {
+        if constexpr (reconstruct) {
+            int id = node.id;
+            while (id >= 0 && std::atomic_ref<int>(decisions[id].references).fetch_sub(1, std::memory_order_acq_rel) == 1) {
+                int parent = decisions[id].parent;
+                context.free_decisions.push_back(id);
+                id = parent;
+            }
+        }
+    }
+
+    Node create_root(SearchContext& context) noexcept {
+        Node root = create_node(-1, 0, 0, 0, context.statistics);
+        if constexpr (reconstruct) {
+            root.id = decisions.allocate(context.free_decisions);
+            Decision& decision = decisions[root.id];
+            decision.parent = -1;
+            decision.index = -1;
+            decision.taken = false;
+            std::atomic_ref<int>(decision.references).store(1, std::memory_order_relaxed);
+        }
+        return root;
+    }
+
+    Node create_node(int index, long long price, int weight, int critical_hint, SearchStatistics& statistics) const noexcept {
+        ++statistics.created_states;
+        Node node{price, price, index, weight}; // если рюкзак полон, то набранная стоимость - максимальная
+        if (weight < max_weight) {
+            int critical = engine.critical_index(index + 1, max_weight - weight, critical_hint);
+            node.upper_boundary = engine.upper_boundary(index + 1, price, weight, critical);
+        }
+        return node;
+    }
+
+    // собирает взятые предметы по цепочке записей состояния node и добавляет к ним completion (позиции в instance.order)
+    void record_solution(const Node& node, long long price, const std::vector<int>& completion = {}) noexcept {
+        std::vector<int> chosen;
+        if constexpr (reconstruct) {
+            for (int id = node.id; id >= 0; id = decisions[id].parent) {
+                if (decisions[id].taken) {
+                    chosen.push_back(instance.order[decisions[id].index]);
+                }
+            }
+            for (int index : completion) {
+                chosen.push_back(instance.order[index]);
+            }
+            std::sort(chosen.begin(), chosen.end());
+        }
+        std::lock_guard<std::mutex> guard(solution_lock);
+        if (solution.price < price) { // другой поток мог успеть найти решение лучше
+            solution = {price, std::move(chosen)};
+            mark_incumbent_time();
+            if (control != nullptr) {
+                control->publish(solution);
+            }
+        }
+    }
+
+    // оценка оптимума после остановки: ни одно непросмотренное состояние потока не даст больше
+    long long remaining_bound(NodeHeap& queue, const SearchContext& context) const noexcept {
+        long long bound = incumbent();
+        if (!queue.empty()) {
+            bound = std::max(bound, queue.top().upper_boundary); // вершина кучи - наибольшая оценка в очереди
+        }
+        for (const Node& node : context.stack) {
+            bound = std::max(bound, node.upper_boundary);
+        }
+        return bound;
+    }
+
+    /*
+    Ныряние: жадно достраивает состояние до листа, беря по порядку все помещающиеся предметы.
+    Куски подряд помещающихся предметов берутся целиком по префиксным суммам движка оценок, поэтому ныряние
+    стоит O(log n) на каждый пропущенный предмет, а не O(n).
+    */
+    void dive(const Node& node, SearchContext& context) noexcept {
+        ++context.statistics.dives;
+        context.dive_items.clear();
+        long long price = node.price;
+        int weight = node.weight;
+        int first = index_of(node) + 1;
+        while (first <= last_index && weight < max_weight) {
+            int critical = engine.critical_index(first, max_weight - weight, first);
+            price += engine.prefix_price[critical] - engine.prefix_price[first];
+            weight += static_cast<int>(engine.prefix_weight[critical] - engine.prefix_weight[first]);
+            if constexpr (reconstruct) {
+                for (int i = first; i < critical; ++i) {
+                    context.dive_items.push_back(i);
+                }
+            }
+            first = critical + 1; // критический предмет не помещается
+        }
+        if (update_incumbent(price)) {
+            ++context.statistics.dive_improvements;
+            record_solution(node, price, context.dive_items);
+            context.probe.incumbent(price);
+        }
+    }
+
+    // ныряет от состояния, взятого из очереди, раз в dive_interval таких состояний
+    void dive_periodically(const Node& node, SearchContext& context) noexcept {
+        if (0 < dive_interval && --context.states_until_dive <= 0) {
+            context.states_until_dive = dive_interval;
+            dive(node, context);
+        }
+    }
+
+    // раскрывает состояние: обновляет лучшую цену в листе или передает в push перспективных потомков, затем освобождает состояние
+    template <typename Push>
+    void expand(const Node& node, SearchContext& context, Push&& push) noexcept {
+        context.probe.expanded();
+        int index = index_of(node);
+        if (index == last_index) { // если обработали последний предмет
+            if (update_incumbent(node.price)) { // обновляем лучшую цену
+                record_solution(node, node.price);
+                context.probe.incumbent(node.price);
+            }
+            release(node, context);
+            return;
+        }
+
+        int next_index = index + 1;
+        int next_price = instance.sorted_prices[next_index];
+        int next_weight = instance.sorted_weights[next_index];
+        int critical = node.weight < max_weight ? engine.critical_index(next_index, max_weight - node.weight, next_index) : next_index; // критический предмет состояния
+        Node without_next_item = create_node(next_index, node.price, node.weight, critical, context.statistics);
+        if (incumbent() < without_next_item.upper_boundary) {
+            without_next_item.id = child_id(node, next_index, false, context);
+            push(without_next_item);
+        } else {
+            context.probe.pruned();
+        }
+
+        if (node.weight + next_weight <= max_weight) {
+            Node with_next_item = create_node(next_index, node.price + next_price, node.weight + next_weight, critical, context.statistics);
+            if (incumbent() < with_next_item.upper_boundary) {
+                with_next_item.id = child_id(node, next_index, true, context);
+                push(with_next_item);
+            } else {
+                context.probe.pruned();
+            }
+        }
+        release(node, context);
+    }
+
+    // поиск в глубину по поддереву; в стеке на каждом уровне остается не больше одного брата, поэтому размер стека не больше n + 1
+    // until_incumbent - остановиться, как только рекорд улучшится (SearchStrategy::hybrid); непросмотренные состояния остаются в стеке
+    void depth_first_search(const Node& root, SearchContext& context, bool until_incumbent = false) noexcept {
+        long long created_before = context.statistics.created_states;
+        long long start_price = until_incumbent ? incumbent() : LLONG_MAX;
+        context.stack.push_back(root);
+        while (!context.stack.empty() && !context.stop.stop_requested() && start_price >= incumbent()) {
+            import_shared(context);
+            Node node = context.stack.back();
+            context.stack.pop_back();
+            if (node.upper_boundary <= incumbent()) {
+                context.probe.pruned();
+                release(node, context);
+                continue;
+            }
+            expand(node, context, [&](const Node& child) {
+                context.stack.push_back(child); // предмет кладется в стек последним и рассматривается первым
+            });
+            context.statistics.peak_stack_size = std::max(context.statistics.peak_stack_size, context.stack.size());
+        }
+        context.statistics.depth_first_states += context.statistics.created_states - created_before;
+    }
+};
+
+inline size_t heap_capacity(size_t memory_limit) noexcept { // сколько состояний помещается в memory_limit байт
+    return std::max<size_t>(memory_limit / sizeof(Node), NodeHeap::offset + 1) - NodeHeap::offset;
+}
+
+// memory_limit - ограничение памяти на очередь состояний и записи решений (в байтах), после его достижения поддеревья обходятся в глубину
+// statistics - если не nullptr, сюда записывается статистика поиска
+// instrumentation - если не nullptr, сюда пишутся счетчики во время поиска (см. instrumentation.h)
+// control - срок, отмена и обратный вызов для рекордов; после остановки возвращается рекорд, а upper_bound - оценка
+// по непросмотренным состояниям (stopped = true, если она больше рекорда)
+// options - начальный рекорд, ныряния и порядок обхода (см. SearchOptions)
+// reconstruct = false - только стоимость, без списка предметов
+template <bool reconstruct = true>
+inline Solution solve(const Instance& instance, size_t memory_limit = MEMORY_LIMIT, SearchStatistics* statistics = nullptr,
+    Instrumentation* instrumentation = nullptr, SolveControl* control = nullptr, const SearchOptions& options = SearchOptions()) noexcept {
+    PhaseTimer phase(instrumentation, Phase::initialization);
+    BranchAndBound<reconstruct> search(instance, memory_limit, control, options);
+    SearchContext context(instance.count + 2, instrumentation, control);
+
+    NodeHeap queue(heap_capacity(memory_limit));
+    auto push = [&](const Node& child) {
+        if (queue.full() || search.memory_exhausted(queue.count)) {
+            search.depth_first_search(child, context); // память закончилась - обходим поддерево в глубину
+        } else {
+            queue.push(child);
+            context.statistics.peak_queue_size = std::max(context.statistics.peak_queue_size, queue.count);
+            context.probe.queue_size(queue.count);
+        }
+    };
+    Node root = search.create_root(context);
+    phase.next(Phase::search);
+    if (options.strategy == SearchStrategy::best_first) {
+        queue.push(root);
+    } else {
+        search.depth_first_search(root, context, options.strategy == SearchStrategy::hybrid);
+        if (!context.stop.stop_requested()) { // остановленный поиск оставляет стек для оценки
+            std::vector<Node> pending(context.stack.begin(), context.stack.end()); // push может снова занять стек
+            context.stack.clear();
+            for (const Node& node : pending) {
+                push(node);
+            }
+        }
+    }
+    while (!queue.empty() && !context.stop.stop_requested()) {
+        search.import_shared(context);
+        Node current_state = queue.pop();
+
+        if (current_state.upper_boundary <= search.incumbent()) {
+            context.probe.pruned();
+            search.release(current_state, context);
+            continue; // точно не наберем цену лучше
+        }
+
+        search.dive_periodically(current_state, context);
+        search.expand(current_state, context, push);
+    }
+
+    if (statistics != nullptr) {
+        search.write_times(context.statistics);
+        context.statistics.peak_memory = queue.pool.allocated_bytes();
+        context.statistics.decisions_memory = search.decisions.allocated_bytes();
+        *statistics = context.statistics;
+    }
+    Solution solution = std::move(search.solution);
+    solution.upper_bound = search.remaining_bound(queue, context);
+    solution.stopped = solution.price < solution.upper_bound;
+    return solution;
+}
+
+// очередь потока: из нее берет состояния сам поток и крадут остальные потоки, когда их очереди пусты
+struct Worker {
+    std::mutex lock;
+    NodeHeap queue;
+    SearchContext context;
+
+    Worker(size_t queue_capacity, size_t stack_capacity, Instrumentation* instrumentation, SolveControl* control) :
+        queue(queue_capacity),
+        context(stack_capacity, instrumentation, control) {}
+
+    bool try_pop(Node& node) noexcept {
+        std::lock_guard<std::mutex> guard(lock);
+        if (queue.empty()) {
+            return false;
+        }
+        node = queue.pop();
+        return true;
+    }
+};
+
+/*
+Параллельный поиск "лучший-первым": у каждого потока своя очередь, опустевший поток крадет лучшее состояние из очереди другого потока.
+Рекорд общий, поэтому отсечение в каждом потоке идет по лучшему решению, найденному любым потоком.
+Ограничение памяти общее: в нем учитываются очереди всех потоков и записи решений. Стоимость совпадает с solve, так как оптимальная стоимость единственна
+(набор предметов при нескольких оптимальных решениях может отличаться).
+Стек не делится между потоками, поэтому SearchStrategy::depth_first здесь работает как hybrid: первый спуск до рекорда
+делает один поток, дальше - лучший-первым.
+*/
+template <bool reconstruct = true>
+inline Solution parallel_solve(const Instance& instance, int threads_count, size_t memory_limit = MEMORY_LIMIT, SearchStatistics* statistics = nullptr,
+    Instrumentation* instrumentation = nullptr, SolveControl* control = nullptr, const SearchOptions& options = SearchOptions()) noexcept {
+    PhaseTimer phase(instrumentation, Phase::initialization);
+    threads_count = std::max(threads_count, 1);
+    BranchAndBound<reconstruct> search(instance, memory_limit, control, options);
+
+    std::vector<std::unique_ptr<Worker>> workers;
+    for (int i = 0; i < threads_count; ++i) {
+        workers.push_back(std::make_unique<Worker>(heap_capacity(memory_limit), instance.count + 2, instrumentation, control));
+    }
+
+    std::atomic<long long> pending_states(0); // состояния в очередях и раскрываемые прямо сейчас; 0 - поиск закончен
+    Worker& first_worker = *workers[0];
+    Node root = search.create_root(first_worker.context);
+    phase.next(Phase::search);
+    std::vector<Node> initial_states{root};
+    if (options.strategy != SearchStrategy::best_first) {
+        search.depth_first_search(root, first_worker.context, true);
+        initial_states.assign(first_worker.context.stack.begin(), first_worker.context.stack.end());
+        first_worker.context.stack.clear();
+    }
+    for (const Node& node : initial_states) {
+        if (first_worker.queue.full()) {
+            search.depth_first_search(node, first_worker.context);
+        } else {
+            first_worker.queue.push(node);
+            pending_states.fetch_add(1, std::memory_order_relaxed);
+        }
+    }
+
+    auto work = [&](int thread_id) {
+        Worker& worker = *workers[thread_id];
+        auto push = [&](const Node& child) {
+            std::unique_lock<std::mutex> guard(worker.lock);
+            if (worker.queue.full() || search.memory_exhausted(pending_states.load(std::memory_order_relaxed))) {
+                guard.unlock();
+                search.depth_first_search(child, worker.context); // память потока закончилась - обходим поддерево в глубину
+            } else {
+                worker.queue.push(child);
+                worker.context.statistics.peak_queue_size = std::max(worker.context.statistics.peak_queue_size, worker.queue.count);
+                worker.context.probe.queue_size(worker.queue.count);
+                pending_states.fetch_add(1, std::memory_order_relaxed);
+            }
+        };
+
+        while (!worker.context.stop.stop_requested()) { // остановленный поток оставляет свои состояния в очереди и стеке для оценки
+            Node current_state;
+            bool found = worker.try_pop(current_state);
+            for (int i = 1; i < threads_count && !found; ++i) {
+                found = workers[(thread_id + i) % threads_count]->try_pop(current_state); // кража
+            }
+            if (!found) {
+                if (pending_states.load() == 0) {
+                    break;
+                }
+                std::this_thread::yield();
+                continue;
+            }
+
+            search.import_shared(worker.context);
+            if (search.incumbent() < current_state.upper_boundary) {
+                search.dive_periodically(current_state, worker.context);
+                search.expand(current_state, worker.context, push);
+            } else {
+                worker.context.probe.pruned();
+                search.release(current_state, worker.context);
+            }
+            pending_states.fetch_sub(1); // потомки уже в очереди, поэтому счетчик не обнулится раньше времени
+        }
+    };
+
+    std::vector<std::thread> threads;
+    for (int i = 1; i < threads_count; ++i) {
+        threads.emplace_back(work, i);
+    }
+    work(0);
+    for (auto& thread : threads) {
+        thread.join();
+    }
+
+    if (statistics != nullptr) {
+        *statistics = SearchStatistics();
+        for (auto& worker : workers) {
+            worker->context.statistics.peak_memory = worker->queue.pool.allocated_bytes();
+            statistics->merge(worker->context.statistics);
+        }
+        statistics->decisions_memory = search.decisions.allocated_bytes();
+        search.write_times(*statistics);
+    }
+    Solution solution = std::move(search.solution);
+    solution.upper_bound = search.incumbent();
+    for (auto& worker : workers) {
+        solution.upper_bound = std::max(solution.upper_bound, search.remaining_bound(worker->queue, worker->context));
+    }
+    solution.stopped = solution.price < solution.upper_bound;
+    return solution;
+}
+
+/*
+Обобщенная задача (extended_instance.h): несколько ограничений, кратности, классы.
+Уровень дерева - класс, варианты уровня - помещающиеся части класса по убыванию стоимости, затем "ничего из класса".
+Состояние хранит d занятых вместимостей, поэтому вместо очереди с упакованными состояниями - поиск в глубину:
+память O(n * d), а первый же спуск дает жадный рекорд. Отсечение - по оценке extended_upper_bound.
+statistics - если не nullptr, сюда пишется число созданных состояний (created_states).
+*/
+inline Solution solve_extended(const ExtendedProblem& problem, SearchStatistics* statistics = nullptr, SolveControl* control = nullptr) {
+    const int groups_count = problem.groups_count();
+    StopPoller stop(control, STOP_POLL_STATES);
+    std::vector<int> used(problem.dimensions, 0);
+    std::vector<char> fits(problem.count);
+    std::vector<int> option(groups_count + 1, 0); // номер следующего варианта на каждом уровне
+    std::vector<int> chosen(groups_count, -1); // выбранная на уровне часть, -1 - ничего
+    long long price = 0;
+    long long best_price = 0;
+    std::vector<int> best_parts;
+    long long created_states = 1;
+    const long long root_bound = extended_upper_bound(problem, 0, 0, used.data());
+
+    auto take = [&](int part, int sign) {
+        price += sign * problem.prices[part];
+        for (int k = 0; k < problem.dimensions; ++k) {
+            used[k] += sign * problem.weight(k, part);
+        }
+    };
+
+    int group = 0;
+    bool entered = true; // состояние на уровне group только что создано
+    while (0 <= group && !stop.stop_requested()) {
+        if (entered) {
+            entered = false;
+            if (group == groups_count) { // лист
+                if (best_price < price) {
+                    best_price = price;
+                    best_parts.clear();
+                    for (int part : chosen) {
+                        if (0 <= part) {
+                            best_parts.push_back(part);
+                        }
+                    }
+                    if (control != nullptr) {
+                        control->publish(extended_solution(problem, best_parts));
+                    }
+                }
+                option[group] = INT_MAX;
+            } else if (extended_upper_bound(problem, group, price, used.data()) <= best_price) {
+                option[group] = INT_MAX; // точно не наберем цену лучше
+            } else {
+                option[group] = 0;
+                fitting_parts(problem, group, used.data(), fits.data() + problem.group_start[group]);
+            }
+        }
+
+        int size = group < groups_count ? problem.group_start[group + 1] - problem.group_start[group] : 0;
+        if (option[group] < size) {
+            int part = problem.group_start[group] + option[group]++;
+            if (fits[part]) {
+                take(part, 1);
+                chosen[group++] = part;
+                entered = true;
+                ++created_states;
+            }
+        } else if (option[group] == size) { // ничего из класса
+            ++option[group];
+            chosen[group++] = -1;
+            entered = true;
+            ++created_states;
+        } else { // варианты уровня кончились - возврат
+            if (0 < group && 0 <= chosen[group - 1]) {
+                take(chosen[group - 1], -1);
+            }
+            --group;
+        }
+    }
+
+    if (statistics != nullptr) {
+        *statistics = SearchStatistics();
+        statistics->created_states = created_states;
+    }
+    Solution solution = extended_solution(problem, best_parts);
+    solution.stopped = stop.stopped() && best_price < root_bound;
+    solution.upper_bound = solution.stopped ? root_bound : solution.price;
+    return solution;
+}
+
+class BranchAndBoundSolver : public Solver {
+public:
+    int threads_count = THREADS_COUNT; // 1 - последовательный поиск
+    size_t memory_limit = MEMORY_LIMIT;
+    SearchOptions options; // параметры warm_start (0 или 1), dive_interval, strategy (best_first, depth_first или hybrid) и martello_toth (0 или 1)
+
+    const char* name() const noexcept override {
+        return "branch_bound";
+    }
+
+protected:
+    Solution solve_instance(const Instance& instance, SolveControl& control) const override {
+        Solution solution = threads_count > 1 && options.strategy != SearchStrategy::depth_first ? parallel_solve(instance, threads_count, memory_limit, nullptr, instrumentation, &control, options)
+            : branch_bound::solve(instance, memory_limit, nullptr, instrumentation, &control, options);
+        if (solution.stopped) { // поиск по лучшей оценке мог не дойти ни до одного листа - тогда жадный ответ лучше рекорда
+            Solution greedy_solution = greedy::solve(instance);
+            if (solution.price < greedy_solution.price) {
+                greedy_solution.upper_bound = solution.upper_bound;
+                greedy_solution.stopped = greedy_solution.price < greedy_solution.upper_bound;
+                solution = std::move(greedy_solution);
+                control.publish(solution);
+            }
+        }
+        return solution;
+    }
+
+    ParameterStatus set_solver_parameter(const std::string& name, const std::string& value) override {
+        bool parsed;
+        if (name == "threads_count") {
+            parsed = parse_number(value, threads_count) && 0 < threads_count;
+        } else if (name == "memory_limit") {
+            parsed = parse_number(value, memory_limit);
+        } else if (name == "warm_start") {
+            int number;
+            parsed = parse_number(value, number) && (number == 0 || number == 1);
+            options.warm_start = parsed ? number == 1 : options.warm_start;
+        } else if (name == "dive_interval") {
+            parsed = parse_number(value, options.dive_interval) && 0 <= options.dive_interval;
+        } else if (name == "strategy") {
+            parsed = parse_strategy(value, options.strategy);
+        } else if (name == "martello_toth") {
+            int number;
+            parsed = parse_number(value, number) && (number == 0 || number == 1);
+            options.martello_toth = parsed ? number == 1 : options.martello_toth;
+        } else {
+            return ParameterStatus::unknown;
+        }
+        return parsed ? ParameterStatus::applied : ParameterStatus::invalid;
+    }
+};
+
+}
\ No newline at end of file
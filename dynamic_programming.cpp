@@ -0,0 +1,184 @@
+#include <iostream>
+#include <fstream>
+#include <string>
+#include <vector>
+#include <algorithm>
+#include <random>
+#include <chrono>
+#include "dynamic_programming.h"
+
+using namespace std;
+using namespace dynamic_programming;
+
+#if defined(BENCHMARK)
+// случайные предметы: вес от 1 до 1000, стоимость - случайная или сильно коррелированная с весом (вес + 100), вместимость - половина суммарного веса
+vector<Item> generate_items(int n, int& max_weight, unsigned int seed, bool correlated = false) noexcept {
+    mt19937 generator(seed);
+    uniform_int_distribution<int> distribution(1, 1000);
+    vector<Item> items(n);
+    long long total_weight = 0;
+    for (auto& item : items) {
+        item.weight = distribution(generator);
+        item.price = correlated ? item.weight + 100 : distribution(generator);
+        total_weight += item.weight;
+    }
+    max_weight = static_cast<int>(total_weight / 2);
+    return items;
+}
+
+// время и память без восстановления ответа (одна строка) и с ним (две строки на верхнем уровне рекурсии)
+void print_run(const string& name, int n, int max_weight, const vector<Item>& items) {
+    Instance instance;
+    prepare_instance(max_weight, items, instance);
+    auto start = chrono::high_resolution_clock::now();
+    long long best_price = solve_price(instance);
+    auto end = chrono::high_resolution_clock::now();
+    double seconds = chrono::duration<double>(end - start).count();
+
+    start = chrono::high_resolution_clock::now();
+    Solution solution = solve(instance);
+    end = chrono::high_resolution_clock::now();
+    double reconstruct_seconds = chrono::duration<double>(end - start).count();
+
+    size_t row_bytes = (max_weight + 1ull) * sizeof(long long);
+    cout << name << '\t' << n << '\t' << max_weight << '\t' << seconds * 1000 << '\t' << static_cast<long long>(n * (max_weight + 1.0) / seconds) << '\t' << row_bytes << '\t'
+        << reconstruct_seconds * 1000 << '\t' << (reconstruct_seconds / seconds - 1) * 100 << "%\t" << 2 * row_bytes << '\t'
+        << best_price << '\t' << (solution.price == best_price ? "yes" : "no") << '\t' << solution.items.size() << '\n';
+}
+
+// те же экземпляры (генератор и зерна), что и в benchmark() из branch_bound.cpp, - столбцы milliseconds и best price сравнимы напрямую
+void benchmark() {
+    cout << "instance\tn\tmax weight\tmilliseconds\tcells/sec\tbytes\tmilliseconds with items\ttime overhead\tbytes with items\tbest price\tsame price with items\titems taken\n";
+    for (int n : {1000, 2000, 5000, 10000}) {
+        int max_weight;
+        vector<Item> items = generate_items(n, max_weight, n);
+        print_run("uncorrelated", n, max_weight, items);
+    }
+    for (int n : {40, 60, 80}) {
+        int max_weight;
+        vector<Item> items = generate_items(n, max_weight, n, true);
+        print_run("correlated", n, max_weight, items);
+    }
+
+    // большие вместимости: строка обновляется по предмету за проход (как на малых вместимостях) или блоками по плиткам с потоками (fill_best)
+    cout << "\nn\tmax weight\tper item ms\tper item cells/sec\tblocked ms\tblocked cells/sec\tspeedup\tsame row\n";
+    for (int max_weight : {1 << 22, 1 << 24, 1 << 26}) {
+        mt19937 generator(max_weight);
+        uniform_int_distribution<int> distribution(1, RING_SIZE_LIMIT - TILE_SIZE); // все предметы легкие и попадают в блоки
+        int n = 32;
+        vector<Item> items(n);
+        for (auto& item : items) {
+            item.weight = distribution(generator);
+            item.price = distribution(generator);
+        }
+        Instance instance;
+        prepare_instance(max_weight, items, instance);
+        auto start = chrono::high_resolution_clock::now();
+        vector<long long> per_item(max_weight + 1, 0);
+        for (int i = 0; i < n; ++i) {
+            update_range(per_item.data(), per_item.data(), instance.weights[i], max_weight + 1, instance.weights[i], instance.prices[i]);
+        }
+        double per_item_seconds = chrono::duration<double>(chrono::high_resolution_clock::now() - start).count();
+        start = chrono::high_resolution_clock::now();
+        vector<long long> blocked;
+        fill_best(instance, 0, n, max_weight, blocked);
+        double blocked_seconds = chrono::duration<double>(chrono::high_resolution_clock::now() - start).count();
+        double cells = n * (max_weight + 1.0);
+        cout << n << '\t' << max_weight << '\t' << per_item_seconds * 1000 << '\t' << static_cast<long long>(cells / per_item_seconds) << '\t'
+            << blocked_seconds * 1000 << '\t' << static_cast<long long>(cells / blocked_seconds) << '\t' << per_item_seconds / blocked_seconds << '\t'
+            << (per_item == blocked ? "yes" : "no") << '\n';
+    }
+
+    // выбор представления: списки Парето против строк динамики
+    cout << "\ninstance\tn\tmax weight\tchosen\tsparse states\tpeak list\tdense cells\tmilliseconds\tdense milliseconds\tbest price\tsame price\n";
+    auto compare = [](const string& name, const vector<Item>& items, int max_weight) {
+        Instance instance;
+        prepare_instance(max_weight, items, instance);
+        Statistics statistics;
+        auto start = chrono::high_resolution_clock::now();
+        Solution solution = solve(instance, nullptr, nullptr, true, &statistics);
+        double seconds = chrono::duration<double>(chrono::high_resolution_clock::now() - start).count();
+        start = chrono::high_resolution_clock::now();
+        Solution dense = solve(instance, nullptr, nullptr, false);
+        double dense_seconds = chrono::duration<double>(chrono::high_resolution_clock::now() - start).count();
+        cout << name << '\t' << items.size() << '\t' << max_weight << '\t' << (statistics.sparse ? "sparse" : "dense") << '\t'
+            << statistics.sparse_states << '\t' << statistics.peak_list_size << '\t' << statistics.dense_cells << '\t'
+            << seconds * 1000 << '\t' << dense_seconds * 1000 << '\t' << solution.price << '\t' << (solution.price == dense.price ? "yes" : "no") << '\n';
+    };
+    for (int n : {1000, 10000}) {
+        int max_weight;
+        vector<Item> items = generate_items(n, max_weight, n);
+        compare("uncorrelated", items, max_weight);
+    }
+    for (int n : {16, 20}) { // мало предметов с огромными весами: достижимых весов не больше 2^n
+        mt19937 generator(n);
+        uniform_int_distribution<int> distribution(1, 10000000);
+        vector<Item> items(n);
+        long long total_weight = 0;
+        for (auto& item : items) {
+            item.weight = distribution(generator);
+            item.price = distribution(generator) / 100;
+            total_weight += item.weight;
+        }
+        compare("huge weights", items, static_cast<int>(total_weight / 2));
+    }
+    for (int n : {200, 500}) { // веса кратны 100: достижимых весов в 100 раз меньше, чем ячеек строки
+        mt19937 generator(n);
+        uniform_int_distribution<int> distribution(1, 1000);
+        vector<Item> items(n);
+        long long total_weight = 0;
+        for (auto& item : items) {
+            item.weight = distribution(generator) * 100;
+            item.price = distribution(generator);
+            total_weight += item.weight;
+        }
+        compare("coarse weights", items, static_cast<int>(total_weight / 2));
+    }
+}
+#endif
+
+// Аргументы командной строки: --config=файл и --time_limit=мс (срок решения, по истечении выводится лучший найденный ответ)
+// --extended - задача с несколькими ограничениями, кратностями или классами (формат - в extended_instance.h)
+int main(int argc, char* argv[]) {
+#if defined(BENCHMARK)
+    benchmark();
+    return 0;
+#endif
+    DynamicProgrammingSolver solver;
+    BatchOptions batch;
+    StatisticsOptions statistics;
+    bool extended = false;
+    if (!parse_batch_arguments(argc, argv, batch) || !parse_statistics_arguments(argc, argv, statistics) || !parse_extended_arguments(argc, argv, extended)
+        || !parse_arguments({&solver}, argc, argv)) {
+        return 1;
+    }
+    if (extended) {
+        return run_extended(solver, [](const ExtendedProblem& problem, Solution& solution, SolveControl& control) {
+            return solve_extended(problem, solution, &control);
+        });
+    }
+    Instrumentation instrumentation;
+    StatisticsReporter reporter(instrumentation, statistics); // выводит статистику, только если она запрошена
+    if (statistics.enabled) {
+        solver.instrumentation = &instrumentation;
+    }
+    if (batch.source != BatchSource::none) {
+        return run_batch(batch, solver);
+    }
+    Instance instance;
+    if (!input_data(instance)) {
+        return 1;
+    }
+    cancel_on_interrupt(solver);
+    auto start = chrono::high_resolution_clock::now();
+    ReductionStatistics reduction;
+    Solution solution = solver.solve(instance, &reduction);
+    auto end = chrono::high_resolution_clock::now();
+    reporter.stop();
+    if (solver.reduction) {
+        print_reduction(reduction);
+    }
+    print_solution(solution, end - start);
+    wait_for_exit();
+    return 0;
+}
\ No newline at end of file
@@ -0,0 +1,583 @@
+#pragma once
+
+#include <vector>
+#include <algorithm>
+#include <climits>
+#if defined(__AVX2__) || defined(__SSE4_2__)
+#include <immintrin.h>
+#endif
+#if defined(_OPENMP)
+#include <omp.h>
+#endif
+#include "knapsack.h"
+#include "greedy.h"
+#include "extended_instance.h"
+
+#define PARALLEL_MIN_WEIGHT (1 << 18) // с какой вместимости диапазон весов делится между потоками OpenMP (при сборке с -fopenmp)
+#define BLOCKED_MIN_WEIGHT (1 << 24) // с какой вместимости строка обновляется блоками предметов по плиткам (см. update_block)
+#define BLOCK_ITEMS 8 // число предметов в блоке
+#define TILE_SIZE (1 << 12) // ширина плитки по вместимости
+#define RING_SIZE_LIMIT (1 << 15) // наибольший кольцевой буфер промежуточной строки блока; более тяжелые предметы обновляют строку по одному
+#define SPARSE_STATES 1 // 1 - сначала динамика по спискам Парето (solve_sparse), 0 - сразу строки динамики
+#define SPARSE_DENSITY 16 // от списков Парето отказываемся, когда в списке больше (max_weight + 1) / SPARSE_DENSITY состояний
+#define SPARSE_MAX_STATES (1 << 24) // наибольшее суммарное число состояний всех списков Парето (они хранятся для восстановления ответа)
+#define STOP_POLL_CELLS (1 << 22) // через сколько ячеек динамики проверяется срок решения
+#define EXTENDED_MEMORY_LIMIT (1ull << 30) // ограничение памяти на строки динамики обобщенной задачи, байт
+
+namespace dynamic_programming {
+
+#if defined(__AVX2__)
+inline __m256i max_epi64(__m256i lhs, __m256i rhs) noexcept { // в AVX2 нет 64-битного max
+    return _mm256_blendv_epi8(lhs, rhs, _mm256_cmpgt_epi64(rhs, lhs));
+}
+#elif defined(__SSE4_2__)
+inline __m128i max_epi64(__m128i lhs, __m128i rhs) noexcept {
+    return _mm_blendv_epi8(lhs, rhs, _mm_cmpgt_epi64(rhs, lhs));
+}
+#endif
+
+/*
+Обновление строки динамики одним предметом: target[c] = max(source[c], source[c - weight] + price) для c из [from, to).
+Значения строки 64-битные: сумма 32-битных стоимостей может не поместиться в int.
+Веса перебираются по убыванию, поэтому при target == source значения source[c - weight] еще не обновлены и
+достаточно одного массива. Блок из 4 (AVX2) или 2 (SSE4.2) значений сначала целиком читается, затем записывается,
+поэтому порядок внутри блока не важен.
+*/
+inline void update_range(const long long* source, long long* target, int from, int to, int weight, int price) noexcept {
+    int c = to - 1;
+#if defined(__AVX2__)
+    __m256i prices = _mm256_set1_epi64x(price);
+    for (; c - 3 >= from; c -= 4) {
+        __m256i without_item = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(source + c - 3));
+        __m256i with_item = _mm256_add_epi64(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(source + c - 3 - weight)), prices);
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(target + c - 3), max_epi64(without_item, with_item));
+    }
+#elif defined(__SSE4_2__)
+    __m128i prices = _mm_set1_epi64x(price);
+    for (; c - 1 >= from; c -= 2) {
+        __m128i without_item = _mm_loadu_si128(reinterpret_cast<const __m128i*>(source + c - 1));
+        __m128i with_item = _mm_add_epi64(_mm_loadu_si128(reinterpret_cast<const __m128i*>(source + c - 1 - weight)), prices);
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(target + c - 1), max_epi64(without_item, with_item));
+    }
+#endif
+    for (; c >= from; --c) {
+        target[c] = std::max(source[c], source[c - weight] + price);
+    }
+}
+
+// target[k] = max(without[k], with[k] + price), k < count; target не пересекается с without и with
+inline void merge_range(const long long* __restrict without, const long long* __restrict with, long long* __restrict target, int count, int price) noexcept {
+    int k = 0;
+#if defined(__AVX2__)
+    __m256i prices = _mm256_set1_epi64x(price);
+    for (; k + 4 <= count; k += 4) {
+        __m256i without_item = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(without + k));
+        __m256i with_item = _mm256_add_epi64(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(with + k)), prices);
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(target + k), max_epi64(without_item, with_item));
+    }
+#elif defined(__SSE4_2__)
+    __m128i prices = _mm_set1_epi64x(price);
+    for (; k + 2 <= count; k += 2) {
+        __m128i without_item = _mm_loadu_si128(reinterpret_cast<const __m128i*>(without + k));
+        __m128i with_item = _mm_add_epi64(_mm_loadu_si128(reinterpret_cast<const __m128i*>(with + k)), prices);
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(target + k), max_epi64(without_item, with_item));
+    }
+#endif
+    for (; k < count; ++k) {
+        target[k] = std::max(without[k], with[k] + price);
+    }
+}
+
+/*
+Блок предметов items[0..count) за один проход по строке: source - строка до блока, target - после, считаются позиции [from, to).
+Плитки [a, a + TILE_SIZE) идут по возрастанию вместимости, и в каждой плитке по очереди применяются все предметы блока.
+Промежуточной строке (после первых j предметов блока) нужно помнить только TILE_SIZE + вес следующего предмета позиций
+назад, поэтому она живет в кольцевом буфере rings размером до RING_SIZE_LIMIT, который остается в кэше, а большие строки
+source и target читаются и пишутся один раз на блок, а не на каждый предмет.
+Поток, начинающий не с нуля, начинает на сумму весов блока левее from: промежуточные строки там неверны (левее начала
+значений нет), но последняя строка на [from, to) от этих позиций не зависит.
+*/
+inline void update_block(const Instance& instance, const int* items, int count, const long long* source, long long* target, int from, int to,
+    std::vector<long long>& rings) noexcept {
+    if (count == 1) {
+        int weight = instance.weights[items[0]];
+        int split = std::clamp(weight, from, to); // до веса предмета значения просто копируются
+        std::copy(source + from, source + split, target + from);
+        merge_range(source + split, source + split - weight, target + split, to - split, instance.prices[items[0]]);
+        return;
+    }
+    long long weights_sum = 0;
+    int ring_size = TILE_SIZE;
+    for (int j = 0; j < count; ++j) {
+        weights_sum += instance.weights[items[j]];
+        while (ring_size < TILE_SIZE + instance.weights[items[j]]) {
+            ring_size *= 2;
+        }
+    }
+    rings.resize(static_cast<size_t>(count - 1) * ring_size);
+    const int start = static_cast<int>(std::max(0ll, from - weights_sum));
+    const int mask = ring_size - 1;
+    // промежуточная строка после j предметов блока с позиции p; length - сколько позиций подряд лежит одним куском до конца буфера
+    auto ring = [&](int j, int p, int& length) {
+        int index = (p - start) & mask;
+        length = ring_size - index;
+        return rings.data() + static_cast<size_t>(j - 1) * ring_size + index;
+    };
+    auto read = [&](int j, int p, int& length) -> const long long* {
+        length = INT_MAX;
+        return j == 0 ? source + p : ring(j, p, length);
+    };
+    auto write = [&](int j, int p, int& length) {
+        length = INT_MAX;
+        return j == count ? target + p : ring(j, p, length);
+    };
+
+    for (int a = start; a < to; a += TILE_SIZE) {
+        int b = std::min(a + TILE_SIZE, to);
+        for (int j = 1; j <= count; ++j) {
+            int weight = instance.weights[items[j - 1]];
+            int price = instance.prices[items[j - 1]];
+            int low = j == count ? std::max(a, from) : a;
+            int known = j == 1 ? 0 : start; // левее known строка j - 1 не посчитана
+            int split = std::clamp(known + weight, low, b);
+            for (int p = low; p < b;) {
+                int without_length, with_length = INT_MAX, target_length;
+                const long long* without = read(j - 1, p, without_length);
+                long long* out = write(j, p, target_length);
+                if (p < split) {
+                    int length = std::min({split - p, without_length, target_length});
+                    std::copy(without, without + length, out);
+                    p += length;
+                } else {
+                    const long long* with = read(j - 1, p - weight, with_length);
+                    int length = std::min({b - p, without_length, with_length, target_length});
+                    merge_range(without, with, out, length, price);
+                    p += length;
+                }
+            }
+        }
+    }
+}
+
+// best[c] - максимальная стоимость предметов с индексами из [first, last) суммарного веса не больше c, c = 0..max_weight;
+// на небольших вместимостях храним одну строку динамики - O(max_weight) памяти;
+// на больших (BLOCKED_MIN_WEIGHT, PARALLEL_MIN_WEIGHT) - две строки, которые обновляются блоками предметов (update_block),
+// а при сборке с OpenMP диапазон весов делится между потоками, и потоки ждут друг друга один раз на блок
+// false - решение остановлено (stop), строка не досчитана
+inline bool fill_best(const Instance& instance, int first, int last, int max_weight, std::vector<long long>& best, StopPoller* stop = nullptr) noexcept {
+    best.assign(max_weight + 1, 0);
+    std::vector<int> items; // предметы, которые помещаются
+    for (int i = first; i < last; ++i) {
+        if (instance.weights[i] <= max_weight) {
+            items.push_back(i);
+        }
+    }
+    bool blocked = BLOCKED_MIN_WEIGHT <= max_weight;
+    int threads_count = 1;
+#if defined(_OPENMP)
+    if (PARALLEL_MIN_WEIGHT <= max_weight) {
+        threads_count = omp_get_max_threads();
+    }
+#endif
+    if (!blocked && threads_count == 1) {
+        for (int i : items) {
+            int weight = instance.weights[i];
+            update_range(best.data(), best.data(), weight, max_weight + 1, weight, instance.prices[i]);
+            if (stop != nullptr && stop->stop_requested(max_weight + 1)) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    std::vector<int> block_starts; // блок b - items[block_starts[b], block_starts[b + 1])
+    int block_limit = blocked ? BLOCK_ITEMS : 1;
+    int heaviest = 0;
+    for (int k = 0; k < static_cast<int>(items.size()); ++k) {
+        int weight = instance.weights[items[k]];
+        if (block_starts.empty() || k - block_starts.back() == block_limit || RING_SIZE_LIMIT - TILE_SIZE < std::max(heaviest, weight)) {
+            block_starts.push_back(k);
+            heaviest = 0;
+        }
+        heaviest = std::max(heaviest, weight);
+    }
+    block_starts.push_back(static_cast<int>(items.size()));
+    const int blocks_count = static_cast<int>(block_starts.size()) - 1;
+
+    // строка не обновляется на месте: блок (и соседний поток) читал бы уже обновленные значения
+    std::vector<long long> next_best(max_weight + 1, 0);
+    long long* current = best.data();
+    long long* next = next_best.data();
+    bool stopped = false; // меняется только в single, поэтому все потоки выходят из цикла на одном блоке
+#pragma omp parallel num_threads(threads_count)
+    {
+        int threads = 1, thread_id = 0;
+#if defined(_OPENMP)
+        threads = omp_get_num_threads();
+        thread_id = omp_get_thread_num();
+#endif
+        int chunk = (max_weight + threads) / threads;
+        int from = std::min(thread_id * chunk, max_weight + 1);
+        int to = std::min(from + chunk, max_weight + 1);
+        std::vector<long long> rings;
+        for (int b = 0; b < blocks_count; ++b) {
+            int block_size = block_starts[b + 1] - block_starts[b];
+            bool in_place = threads == 1 && block_size == 1; // тяжелый предмет в одном потоке: на месте, без второй строки
+            if (in_place) {
+                int weight = instance.weights[items[block_starts[b]]];
+                update_range(current, current, weight, max_weight + 1, weight, instance.prices[items[block_starts[b]]]);
+            } else {
+                update_block(instance, items.data() + block_starts[b], block_size, current, next, from, to, rings);
+            }
+#pragma omp barrier
+#pragma omp single
+            {
+                if (!in_place) {
+                    std::swap(current, next);
+                }
+                stopped = stop != nullptr && stop->stop_requested(block_size * (max_weight + 1ll));
+            }
+            if (stopped) {
+                break;
+            }
+        }
+    }
+    if (current != best.data()) {
+        best.swap(next_best);
+    }
+    return !stopped;
+}
+
+// только стоимость: одна строка динамики
+inline long long solve_price(const Instance& instance) noexcept {
+    if (instance.max_weight < 0) {
+        return 0;
+    }
+    std::vector<long long> best;
+    fill_best(instance, 0, instance.count, instance.max_weight, best);
+    return best[instance.max_weight];
+}
+
+/*
+Восстановление ответа по схеме Хиршберга: предметы делятся пополам, для каждой половины считается строка динамики
+(левая - по предметам [first, middle), правая - по [middle, last)), и вместимость делится в точке, где сумма строк максимальна.
+Строки освобождаются до рекурсивных вызовов, поэтому памяти нужно две строки O(max_weight), а время не больше удвоенного.
+*/
+// -1 - решение остановлено (stop)
+inline long long collect_items(const Instance& instance, int first, int last, int max_weight, std::vector<int>& chosen, StopPoller* stop = nullptr) noexcept {
+    if (last - first == 1) {
+        if (instance.weights[first] <= max_weight && 0 < instance.prices[first]) {
+            chosen.push_back(first);
+            return instance.prices[first];
+        }
+        return 0;
+    }
+
+    int middle = first + (last - first) / 2;
+    int split = 0; // вместимость, отдаваемая левой половине
+    long long best_price = -1;
+    {
+        std::vector<long long> left, right;
+        if (!fill_best(instance, first, middle, max_weight, left, stop) || !fill_best(instance, middle, last, max_weight, right, stop)) {
+            return -1;
+        }
+        for (int c = 0; c <= max_weight; ++c) {
+            if (best_price < left[c] + right[max_weight - c]) {
+                best_price = left[c] + right[max_weight - c];
+                split = c;
+            }
+        }
+    }
+    if (collect_items(instance, first, middle, split, chosen, stop) < 0 || collect_items(instance, middle, last, max_weight - split, chosen, stop) < 0) {
+        return -1;
+    }
+    return best_price;
+}
+
+// какое представление динамики выбрано и сколько оно стоило
+struct Statistics {
+    bool sparse = false; // ответ найден по спискам Парето (solve_sparse), иначе - по строкам динамики
+    long long sparse_states = 0; // состояний во всех списках Парето, в том числе до отказа от них
+    size_t peak_list_size = 0; // самый длинный список Парето
+    long long dense_cells = 0; // ячеек прямого прохода по строкам динамики (без проходов восстановления); 0 - строки не считались
+};
+
+// состояние разреженной динамики: вес и стоимость набора предметов
+struct State {
+    int weight;
+    long long price;
+};
+
+/*
+Разреженная динамика: после каждого предмета хранится только список Парето - наборы, которые не хуже никакого набора
+меньшего или того же веса (по возрастанию веса стоимость строго растет). Следующий список - слияние списка с его копией,
+сдвинутой на предмет, без доминируемых состояний. Если достижимых весов мало (мелкие задачи, большие одинаковые веса,
+огромная вместимость), списки намного короче строки max_weight + 1.
+Все списки хранятся подряд, и ответ восстанавливается с конца: состояние есть в предыдущем списке - предмет не взят.
+false - списки стали слишком длинными (SPARSE_DENSITY, SPARSE_MAX_STATES) и строки динамики выгоднее; ответ не записан.
+*/
+inline bool solve_sparse(const Instance& instance, Solution& solution, StopPoller& stop, Statistics& statistics) {
+    const int max_weight = instance.max_weight;
+    const size_t list_limit = (max_weight + 1ull) / SPARSE_DENSITY + 1;
+    std::vector<State> states{{0, 0}};
+    std::vector<size_t> offsets{0, 1}; // список после i предметов - states[offsets[i], offsets[i + 1])
+    for (int i = 0; i < instance.count; ++i) {
+        size_t first = offsets[i], last = offsets[i + 1];
+        int weight = instance.weights[i];
+        int price = instance.prices[i];
+        long long last_price = -1;
+        auto keep = [&](State state) {
+            if (last_price < state.price) {
+                states.push_back(state);
+                last_price = state.price;
+            }
+        };
+        size_t without = first, with = first;
+        while (without < last || with < last) {
+            bool fits = with < last && states[with].weight <= max_weight - weight;
+            State shifted = fits ? State{states[with].weight + weight, states[with].price + price} : State{INT_MAX, 0};
+            if (!fits) {
+                with = last; // дальше сдвинутые состояния только тяжелее
+            }
+            if (without < last && (!fits || states[without].weight < shifted.weight
+                || (states[without].weight == shifted.weight && shifted.price <= states[without].price))) {
+                keep(states[without++]);
+            } else if (fits) {
+                keep(shifted);
+                ++with;
+            }
+        }
+        offsets.push_back(states.size());
+        size_t list_size = offsets[i + 2] - offsets[i + 1];
+        statistics.sparse_states += list_size;
+        statistics.peak_list_size = std::max(statistics.peak_list_size, list_size);
+        if (list_limit < list_size || SPARSE_MAX_STATES < states.size()) {
+            return false;
+        }
+        if (stop.stop_requested(2 * (last - first))) {
+            return true;
+        }
+    }
+
+    State best = states.back(); // в последнем списке самое тяжелое состояние - самое дорогое
+    solution.price = best.price;
+    solution.items.clear();
+    for (int i = instance.count - 1; 0 <= i; --i) {
+        auto first = states.begin() + offsets[i], last = states.begin() + offsets[i + 1];
+        auto found = std::lower_bound(first, last, best.weight, [](const State& state, int weight) { return state.weight < weight; });
+        if (found == last || found->weight != best.weight || found->price != best.price) {
+            solution.items.push_back(i);
+            best.weight -= instance.weights[i];
+            best.price -= instance.prices[i];
+        }
+    }
+    std::reverse(solution.items.begin(), solution.items.end());
+    return true;
+}
+
+/*
+Прямой проход и восстановление по Хиршбергу перемежаются, поэтому все время считается поиском.
+При sparse сначала пробуется разреженная динамика (solve_sparse), а строки динамики считаются, только если списки
+Парето оказались слишком длинными; выбранное представление и его размер пишутся в statistics, если он не nullptr.
+Промежуточного ответа у динамики нет: если решение остановлено (control), возвращается жадный ответ с оценкой Данцига.
+*/
+inline Solution solve(const Instance& instance, Instrumentation* instrumentation = nullptr, SolveControl* control = nullptr, bool sparse = SPARSE_STATES,
+    Statistics* statistics = nullptr) noexcept {
+    PhaseTimer phase(instrumentation, Phase::search);
+    StopPoller stop(control, STOP_POLL_CELLS);
+    Solution solution;
+    Statistics solve_statistics;
+    if (0 <= instance.max_weight && 0 < instance.count) {
+        solve_statistics.sparse = sparse && solve_sparse(instance, solution, stop, solve_statistics);
+        if (!solve_statistics.sparse) {
+            solve_statistics.dense_cells = instance.count * (instance.max_weight + 1ll);
+            solution.price = collect_items(instance, 0, instance.count, instance.max_weight, solution.items, &stop);
+        }
+    }
+    if (statistics != nullptr) {
+        *statistics = solve_statistics;
+    }
+    if (stop.stopped()) {
+        solution = greedy::solve(instance);
+        solution.stopped = true;
+    } else {
+        solution.upper_bound = solution.price;
+    }
+    if (control != nullptr) {
+        control->publish(solution);
+    }
+    return solution;
+}
+
+/*
+Обобщенная задача (extended_instance.h). Строка динамики - все векторы занятой вместимости u, u_k <= capacities[k],
+в смешанной системе счисления: s = u_0 + (C_0 + 1) * (u_1 + (C_1 + 1) * (...)), первое ограничение меняется быстрее всех.
+best[s] - лучшая стоимость классов [first, last) с весами не больше u по каждому ограничению.
+Из класса берется не больше одной части, поэтому класс обновляет строку по копии строки до него: части читают только старые значения.
+Часть с весами w обновляет каждую подстроку первого ограничения (u_1, ..., u_{d-1} >= w) по подстроке, сдвинутой на w, -
+непрерывный цикл без условий, который векторизуется.
+*/
+// false - решение остановлено (stop), строка не досчитана
+inline bool fill_extended(const ExtendedProblem& problem, int first, int last, const std::vector<int>& capacities, std::vector<long long>& best,
+    StopPoller* stop = nullptr) {
+    const int dimensions = problem.dimensions;
+    std::vector<long long> strides(dimensions, 1);
+    for (int k = 1; k < dimensions; ++k) {
+        strides[k] = strides[k - 1] * (capacities[k - 1] + 1);
+    }
+    const long long cells = strides[dimensions - 1] * (capacities[dimensions - 1] + 1);
+    best.assign(cells, 0);
+    std::vector<long long> previous(cells);
+    std::vector<int> digits(dimensions);
+    for (int g = first; g < last; ++g) {
+        std::copy(best.begin(), best.end(), previous.begin());
+        for (int j = problem.group_start[g]; j < problem.group_start[g + 1]; ++j) {
+            long long shift = 0;
+            bool fits = true;
+            for (int k = 0; k < dimensions; ++k) {
+                fits = fits && problem.weight(k, j) <= capacities[k];
+                shift += problem.weight(k, j) * strides[k];
+                digits[k] = problem.weight(k, j);
+            }
+            if (!fits) {
+                continue;
+            }
+            const long long price = problem.prices[j];
+            const int length = capacities[0] + 1 - digits[0];
+            while (true) {
+                long long base = 0;
+                for (int k = 1; k < dimensions; ++k) {
+                    base += digits[k] * strides[k];
+                }
+                long long* target = best.data() + base + digits[0];
+                const long long* source = previous.data() + base + digits[0] - shift;
+                for (int c = 0; c < length; ++c) {
+                    target[c] = std::max(target[c], source[c] + price);
+                }
+                int k = 1; // следующая подстрока: увеличиваем u_1, ..., u_{d-1} как счетчик
+                while (k < dimensions && capacities[k] < ++digits[k]) {
+                    digits[k] = problem.weight(k, j);
+                    ++k;
+                }
+                if (k == dimensions) {
+                    break;
+                }
+            }
+        }
+        if (stop != nullptr && stop->stop_requested(cells)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+/*
+Восстановление по Хиршбергу, как в collect_items: векторы u и C - u имеют индексы s и cells - 1 - s,
+поэтому лучшее деление вместимости между половинами классов ищется тем же проходом по сумме двух строк.
+-1 - решение остановлено (stop)
+*/
+inline long long collect_extended(const ExtendedProblem& problem, int first, int last, const std::vector<int>& capacities, std::vector<int>& chosen,
+    StopPoller* stop = nullptr) {
+    if (last - first == 1) {
+        int best_part = -1;
+        for (int j = problem.group_start[first]; j < problem.group_start[first + 1]; ++j) {
+            bool fits = true;
+            for (int k = 0; k < problem.dimensions; ++k) {
+                fits = fits && problem.weight(k, j) <= capacities[k];
+            }
+            if (fits && (best_part < 0 || problem.prices[best_part] < problem.prices[j])) {
+                best_part = j;
+            }
+        }
+        if (best_part < 0) {
+            return 0;
+        }
+        chosen.push_back(best_part);
+        return problem.prices[best_part];
+    }
+
+    int middle = first + (last - first) / 2;
+    long long split = 0; // индекс вектора вместимости, отдаваемого левой половине
+    long long best_price = -1;
+    {
+        std::vector<long long> left, right;
+        if (!fill_extended(problem, first, middle, capacities, left, stop) || !fill_extended(problem, middle, last, capacities, right, stop)) {
+            return -1;
+        }
+        long long cells = static_cast<long long>(left.size());
+        for (long long s = 0; s < cells; ++s) {
+            if (best_price < left[s] + right[cells - 1 - s]) {
+                best_price = left[s] + right[cells - 1 - s];
+                split = s;
+            }
+        }
+    }
+    std::vector<int> left_capacities(problem.dimensions), right_capacities(problem.dimensions);
+    for (int k = 0; k < problem.dimensions; ++k) {
+        left_capacities[k] = static_cast<int>(split % (capacities[k] + 1));
+        split /= capacities[k] + 1;
+        right_capacities[k] = capacities[k] - left_capacities[k];
+    }
+    if (collect_extended(problem, first, middle, left_capacities, chosen, stop) < 0
+        || collect_extended(problem, middle, last, right_capacities, chosen, stop) < 0) {
+        return -1;
+    }
+    return best_price;
+}
+
+/*
+false - строки динамики (произведение (C_k + 1) по ограничениям, три строки одновременно) не помещаются в EXTENDED_MEMORY_LIMIT;
+для таких задач подходит branch_bound::solve_extended. После остановки (control) возвращается жадный ответ extended_greedy.
+*/
+inline bool solve_extended(const ExtendedProblem& problem, Solution& solution, SolveControl* control = nullptr) {
+    double cells = 1;
+    for (int capacity : problem.capacities) {
+        cells *= capacity + 1.0;
+    }
+    if (EXTENDED_MEMORY_LIMIT < cells * 3 * sizeof(long long)) {
+        std::cerr << "Error: the dynamic programming table of " << cells << " cells per row does not fit into the memory limit.\n";
+        return false;
+    }
+    StopPoller stop(control, STOP_POLL_CELLS);
+    std::vector<int> parts;
+    if (0 < problem.groups_count()) {
+        collect_extended(problem, 0, problem.groups_count(), problem.capacities, parts, &stop);
+    }
+    if (stop.stopped()) {
+        solution = extended_greedy(problem);
+        solution.stopped = true;
+    } else {
+        solution = extended_solution(problem, parts);
+        solution.upper_bound = solution.price;
+    }
+    if (control != nullptr) {
+        control->publish(solution);
+    }
+    return true;
+}
+
+class DynamicProgrammingSolver : public Solver {
+public:
+    bool sparse = SPARSE_STATES; // параметр sparse (0 или 1): пробовать ли сначала списки Парето (solve_sparse)
+
+    const char* name() const noexcept override {
+        return "dynamic_programming";
+    }
+
+protected:
+    Solution solve_instance(const Instance& instance, SolveControl& control) const override {
+        return dynamic_programming::solve(instance, instrumentation, &control, sparse);
+    }
+
+    ParameterStatus set_solver_parameter(const std::string& name, const std::string& value) override {
+        if (name != "sparse") {
+            return ParameterStatus::unknown;
+        }
+        int enabled;
+        bool parsed = parse_number(value, enabled) && (enabled == 0 || enabled == 1);
+        sparse = parsed ? enabled == 1 : sparse;
+        return parsed ? ParameterStatus::applied : ParameterStatus::invalid;
+    }
+};
+
+}
\ No newline at end of file
@@ -0,0 +1,432 @@
+#pragma once
+
+/*
+Обобщенная задача о рюкзаке для точных решателей (branch_bound::solve_extended, dynamic_programming::solve_extended):
+- несколько ограничений (вес, объем, бюджет...): у предмета d весов, у рюкзака d вместимостей;
+- ограниченная кратность: предмет можно взять до bound раз;
+- классы (multiple-choice): из предметов одного класса берется не больше одного.
+
+Текстовый формат: "n d", затем d вместимостей, затем n строк "стоимость вес_1 ... вес_d кратность класс"
+(кратность 1 и класс -1 - обычный предмет). Предметы одного класса должны иметь кратность 1.
+В ответе (Solution::items) индекс предмета повторяется столько раз, сколько его копий взято.
+
+Все варианты сводятся к одному виду (ExtendedProblem): последовательность классов, из каждого берется не больше одной части.
+Предмет кратности m делится на части из 1, 2, 4, ..., 2^(k-1) и остатка копий (двоичное разбиение): любое число копий
+от 0 до m набирается подмножеством частей, а частей всего O(log m). Каждая часть вне класса - отдельный класс из одной части.
+Веса хранятся структурой массивов по ограничениям, weights[k * count + j], поэтому проверка, какие части класса
+помещаются, идет по подряд лежащим весам и векторизуется (fitting_parts).
+*/
+
+#include <iostream>
+#include <fstream>
+#include <string>
+#include <vector>
+#include <algorithm>
+#include <numeric>
+#include <climits>
+#include "knapsack.h"
+
+struct ExtendedInstance {
+    int dimensions = 0; // число ограничений
+    std::vector<int> capacities; // вместимость по каждому ограничению
+    int count = 0; // число предметов
+    std::vector<int> prices;
+    std::vector<int> weights; // weights[k * count + i] - вес предмета i по ограничению k
+    std::vector<int> bounds; // сколько копий предмета можно взять
+    std::vector<int> groups; // класс предмета, -1 - без класса
+};
+
+inline bool load_extended_instance(const std::string& filename, ExtendedInstance& instance) {
+    std::ifstream input(filename);
+    if (!input) {
+        std::cerr << "Error: cannot open file '" << filename << "'.\n";
+        return false;
+    }
+    input >> instance.count >> instance.dimensions;
+    if (!input || instance.count < 0 || instance.dimensions <= 0) {
+        std::cerr << "Error: expected the number of items and the number of constraints.\n";
+        return false;
+    }
+    int count = instance.count;
+    instance.capacities.resize(instance.dimensions);
+    for (int& capacity : instance.capacities) {
+        input >> capacity;
+    }
+    instance.prices.resize(count);
+    instance.weights.resize(static_cast<size_t>(instance.dimensions) * count);
+    instance.bounds.resize(count);
+    instance.groups.resize(count);
+    for (int i = 0; i < count; ++i) {
+        input >> instance.prices[i];
+        for (int k = 0; k < instance.dimensions; ++k) {
+            input >> instance.weights[static_cast<size_t>(k) * count + i];
+        }
+        input >> instance.bounds[i] >> instance.groups[i];
+    }
+    if (!input) {
+        std::cerr << "Error: expected " << instance.dimensions << " capacities and " << count << " lines \"price weights bound group\".\n";
+        return false;
+    }
+    if (std::any_of(instance.capacities.begin(), instance.capacities.end(), [](int capacity) { return capacity < 0; })
+        || std::any_of(instance.weights.begin(), instance.weights.end(), [](int weight) { return weight < 0; })) {
+        std::cerr << "Error: capacities and weights must be non-negative.\n";
+        return false;
+    }
+    for (int i = 0; i < count; ++i) {
+        if (instance.bounds[i] < 1 || instance.groups[i] < -1 || (0 <= instance.groups[i] && instance.bounds[i] != 1)) {
+            std::cerr << "Error: item " << i << " must have bound >= 1, group >= -1 and bound 1 inside a group.\n";
+            return false;
+        }
+    }
+    return true;
+}
+
+// приращение выпуклой оболочки класса в релаксации (см. build_hull)
+struct HullIncrement {
+    int group;
+    double weight;
+    double price;
+};
+
+// ограничения, сложенные с множителями в одно, и приращения оболочек всех классов по убыванию эффективности
+struct Relaxation {
+    std::vector<double> multipliers;
+    std::vector<HullIncrement> increments;
+};
+
+struct ExtendedProblem {
+    int dimensions = 0;
+    std::vector<int> capacities;
+    int count = 0; // число частей
+    std::vector<long long> prices; // стоимость части (копий предмета может быть много, поэтому 64-битная)
+    std::vector<int> weights; // weights[k * count + j] - вес части j по ограничению k
+    std::vector<int> items; // исходный предмет части
+    std::vector<int> copies; // сколько копий предмета в части
+    std::vector<int> group_start; // части класса g - [group_start[g], group_start[g + 1]), внутри класса по убыванию стоимости
+    Relaxation relaxation; // для оценки сверху, см. build_hull
+
+    int groups_count() const noexcept {
+        return static_cast<int>(group_start.size()) - 1;
+    }
+
+    int weight(int dimension, int part) const noexcept {
+        return weights[static_cast<size_t>(dimension) * count + part];
+    }
+};
+
+/*
+Оценка сверху для всех вариантов - линейная релаксация суррогатной задачи.
+Ограничения складываются с множителями u_k в одно, сумма u_k w_jk <= сумма u_k C_k: любой допустимый набор удовлетворяет
+и сумме, поэтому оптимум такой задачи не меньше исходного. При d = 1 это обычная оценка Данцига.
+Множители подбираются при подготовке (prepare_extended): от u_k = 1 / C_k покоординатным поиском, пока уменьшается
+оценка корня. С множителями 1 / C_k оценка заметно хуже, когда одно ограничение теснее остальных.
+В классе с несколькими частями релаксация берет точки верхней выпуклой оболочки (s_j, p_j) вместе с (0, 0):
+части под оболочкой не нужны даже дробно (LP-доминирование), а приращения оболочки идут с убывающей эффективностью,
+поэтому жадный выбор приращений всех классов по убыванию эффективности дает оптимум релаксации (Sinha, Zoltners).
+Части двоичного разбиения предмета имеют одну эффективность, поэтому у ограниченной кратности оценка та же,
+что у релаксации с 0 <= x_i <= m_i.
+*/
+inline void build_hull(const ExtendedProblem& problem, const std::vector<double>& multipliers, int group, std::vector<HullIncrement>& increments) {
+    struct Point {
+        double weight;
+        double price;
+    };
+    std::vector<Point> points;
+    for (int j = problem.group_start[group]; j < problem.group_start[group + 1]; ++j) {
+        double weight = 0;
+        for (int k = 0; k < problem.dimensions; ++k) {
+            weight += multipliers[k] * problem.weight(k, j);
+        }
+        points.push_back({weight, static_cast<double>(problem.prices[j])});
+    }
+    std::sort(points.begin(), points.end(), [](const Point& lhs, const Point& rhs) {
+        return lhs.weight < rhs.weight || (lhs.weight == rhs.weight && rhs.price < lhs.price);
+    });
+    std::vector<Point> hull = {{0, 0}};
+    for (const Point& point : points) {
+        if (point.price <= hull.back().price) {
+            continue; // тяжелее и не дороже уже взятой в оболочку точки
+        }
+        while (hull.size() >= 2) {
+            const Point& a = hull[hull.size() - 2];
+            const Point& b = hull.back();
+            if ((b.weight - a.weight) * (point.price - b.price) < (b.price - a.price) * (point.weight - b.weight)) {
+                break; // b выше отрезка от a до point
+            }
+            hull.pop_back();
+        }
+        hull.push_back(point);
+    }
+    for (size_t i = 1; i < hull.size(); ++i) {
+        increments.push_back({group, hull[i].weight - hull[i - 1].weight, hull[i].price - hull[i - 1].price});
+    }
+}
+
+// эффективность приращения, приращения без веса - первыми
+inline bool more_efficient(const HullIncrement& lhs, const HullIncrement& rhs) noexcept {
+    return lhs.price * rhs.weight > rhs.price * lhs.weight || (lhs.price * rhs.weight == rhs.price * lhs.weight && lhs.group < rhs.group);
+}
+
+inline Relaxation build_relaxation(const ExtendedProblem& problem, std::vector<double> multipliers) {
+    Relaxation relaxation;
+    for (int g = 0; g < problem.groups_count(); ++g) {
+        build_hull(problem, multipliers, g, relaxation.increments);
+    }
+    std::sort(relaxation.increments.begin(), relaxation.increments.end(), more_efficient);
+    relaxation.multipliers = std::move(multipliers);
+    return relaxation;
+}
+
+// оценка релаксации с множителями relaxation.multipliers
+inline long long relaxation_bound(const ExtendedProblem& problem, const Relaxation& relaxation, int group, long long price, const int* used) noexcept {
+    double weight_left = 0;
+    for (int k = 0; k < problem.dimensions; ++k) {
+        weight_left += relaxation.multipliers[k] * (problem.capacities[k] - used[k]);
+    }
+    weight_left = std::max(weight_left, 0.0);
+    for (const HullIncrement& increment : relaxation.increments) {
+        if (increment.group < group) {
+            continue;
+        }
+        if (increment.weight <= weight_left) {
+            weight_left -= increment.weight;
+            price += static_cast<long long>(increment.price);
+        } else {
+            // запас на ошибки округления, чтобы оценка не оказалась меньше настоящей
+            double fraction = increment.price * weight_left / increment.weight;
+            return price + static_cast<long long>(fraction * (1 + 1e-9) + 1e-9);
+        }
+    }
+    return price;
+}
+
+/*
+Сведение к последовательности классов. Предметы без стоимости и не помещающиеся хотя бы по одному ограничению
+отбрасываются, кратность урезается до числа копий, помещающихся по всем ограничениям.
+Классы упорядочены по эффективности первого приращения оболочки: поиск в глубину раньше решает самые выгодные классы.
+*/
+inline void prepare_extended(const ExtendedInstance& instance, ExtendedProblem& problem) {
+    const int dimensions = instance.dimensions;
+    const int count = instance.count;
+    auto weight = [&](int k, int i) {
+        return instance.weights[static_cast<size_t>(k) * count + i];
+    };
+    struct Part {
+        int group; // класс до упорядочивания; предметы без класса получают номера после всех классов
+        int item;
+        int copies;
+    };
+    std::vector<Part> parts;
+    int next_group = 0;
+    for (int i = 0; i < count; ++i) {
+        next_group = std::max(next_group, instance.groups[i] + 1);
+    }
+    for (int i = 0; i < count; ++i) {
+        if (instance.prices[i] <= 0) {
+            continue;
+        }
+        long long bound = instance.bounds[i];
+        for (int k = 0; k < dimensions; ++k) {
+            if (0 < weight(k, i)) {
+                bound = std::min<long long>(bound, instance.capacities[k] / weight(k, i));
+            }
+        }
+        if (0 <= instance.groups[i]) {
+            if (bound == 1) {
+                parts.push_back({instance.groups[i], i, 1});
+            }
+            continue;
+        }
+        for (long long copies = 1; 0 < bound; copies *= 2) {
+            long long taken = std::min(copies, bound);
+            parts.push_back({next_group++, i, static_cast<int>(taken)});
+            bound -= taken;
+        }
+    }
+
+    problem.dimensions = dimensions;
+    problem.capacities = instance.capacities;
+    std::vector<double> surrogate(dimensions, 0);
+    for (int k = 0; k < dimensions; ++k) {
+        if (0 < instance.capacities[k]) {
+            surrogate[k] = 1.0 / instance.capacities[k]; // при нулевой вместимости у оставшихся частей вес 0
+        }
+    }
+
+    // классы по номеру, внутри - по убыванию стоимости
+    std::sort(parts.begin(), parts.end(), [&](const Part& lhs, const Part& rhs) {
+        long long lhs_price = static_cast<long long>(instance.prices[lhs.item]) * lhs.copies;
+        long long rhs_price = static_cast<long long>(instance.prices[rhs.item]) * rhs.copies;
+        return lhs.group < rhs.group || (lhs.group == rhs.group && rhs_price < lhs_price);
+    });
+    auto fill_parts = [&](const std::vector<Part>& ordered) {
+        problem.count = static_cast<int>(ordered.size());
+        problem.prices.resize(problem.count);
+        problem.weights.resize(static_cast<size_t>(dimensions) * problem.count);
+        problem.items.resize(problem.count);
+        problem.copies.resize(problem.count);
+        problem.group_start.assign(1, 0);
+        for (int j = 0; j < problem.count; ++j) {
+            const Part& part = ordered[j];
+            problem.items[j] = part.item;
+            problem.copies[j] = part.copies;
+            problem.prices[j] = static_cast<long long>(instance.prices[part.item]) * part.copies;
+            for (int k = 0; k < dimensions; ++k) {
+                problem.weights[static_cast<size_t>(k) * problem.count + j] = weight(k, part.item) * part.copies; // не больше вместимости
+            }
+            if (j + 1 == problem.count || part.group != ordered[j + 1].group) {
+                problem.group_start.push_back(j + 1);
+            }
+        }
+    };
+    fill_parts(parts);
+
+    // упорядочивание классов по первому приращению оболочки суррогатной релаксации
+    std::vector<HullIncrement> first_increments(problem.groups_count());
+    for (int g = 0; g < problem.groups_count(); ++g) {
+        std::vector<HullIncrement> increments;
+        build_hull(problem, surrogate, g, increments);
+        first_increments[g] = increments.front(); // у каждого класса есть часть с положительной стоимостью
+    }
+    std::vector<int> group_order(problem.groups_count());
+    std::iota(group_order.begin(), group_order.end(), 0);
+    std::stable_sort(group_order.begin(), group_order.end(), [&](int lhs, int rhs) {
+        return more_efficient(first_increments[lhs], first_increments[rhs]);
+    });
+    std::vector<int> new_group(problem.groups_count());
+    for (int g = 0; g < problem.groups_count(); ++g) {
+        new_group[group_order[g]] = g;
+    }
+    std::vector<Part> ordered;
+    ordered.reserve(parts.size());
+    for (int g : group_order) {
+        for (int j = problem.group_start[g]; j < problem.group_start[g + 1]; ++j) {
+            ordered.push_back({new_group[g], problem.items[j], problem.copies[j]});
+        }
+    }
+    fill_parts(ordered);
+
+    problem.relaxation = build_relaxation(problem, surrogate);
+    std::vector<int> empty(dimensions, 0);
+    long long best = relaxation_bound(problem, problem.relaxation, 0, 0, empty.data());
+    for (double factor : {2.0, 1.25, 1.05}) { // шаг множителя уменьшается, когда с прежним оценка больше не улучшается
+        bool improved = true;
+        for (int round = 0; round < 20 && improved; ++round) {
+            improved = false;
+            for (int k = 0; k < dimensions && 1 < dimensions; ++k) {
+                for (double scale : {factor, 1 / factor}) {
+                    std::vector<double> multipliers = problem.relaxation.multipliers;
+                    multipliers[k] *= scale;
+                    Relaxation relaxation = build_relaxation(problem, multipliers);
+                    long long bound = relaxation_bound(problem, relaxation, 0, 0, empty.data());
+                    if (bound < best) {
+                        best = bound;
+                        problem.relaxation = std::move(relaxation);
+                        improved = true;
+                    }
+                }
+            }
+        }
+    }
+}
+
+// оценка сверху (см. build_hull): классы с номерами < group уже решены, набрано price, used[k] - занятая вместимость
+inline long long extended_upper_bound(const ExtendedProblem& problem, int group, long long price, const int* used) noexcept {
+    return relaxation_bound(problem, problem.relaxation, group, price, used);
+}
+
+/*
+Какие части класса group помещаются в оставшуюся вместимость: fits[j - first] для j из [first, last).
+Внешний цикл по ограничениям, внутренний - по подряд лежащим весам частей, поэтому внутренний цикл векторизуется.
+*/
+inline void fitting_parts(const ExtendedProblem& problem, int group, const int* used, char* fits) noexcept {
+    int first = problem.group_start[group];
+    int size = problem.group_start[group + 1] - first;
+    std::fill(fits, fits + size, 1);
+    for (int k = 0; k < problem.dimensions; ++k) {
+        const int* weights = problem.weights.data() + static_cast<size_t>(k) * problem.count + first;
+        int left = problem.capacities[k] - used[k];
+        for (int j = 0; j < size; ++j) {
+            fits[j] &= static_cast<char>(weights[j] <= left);
+        }
+    }
+}
+
+// ответ по выбранным частям: индекс предмета повторяется по числу копий
+inline Solution extended_solution(const ExtendedProblem& problem, const std::vector<int>& parts) {
+    Solution solution;
+    long long price = 0;
+    for (int j : parts) {
+        price += problem.prices[j];
+        solution.items.insert(solution.items.end(), problem.copies[j], problem.items[j]);
+    }
+    solution.price = price;
+    std::sort(solution.items.begin(), solution.items.end());
+    return solution;
+}
+
+// жадный ответ: классы по порядку, из каждого - самая дорогая помещающаяся часть
+inline Solution extended_greedy(const ExtendedProblem& problem) {
+    std::vector<int> used(problem.dimensions, 0);
+    std::vector<char> fits(problem.count);
+    std::vector<int> parts;
+    for (int g = 0; g < problem.groups_count(); ++g) {
+        fitting_parts(problem, g, used.data(), fits.data() + problem.group_start[g]);
+        for (int j = problem.group_start[g]; j < problem.group_start[g + 1]; ++j) {
+            if (fits[j]) {
+                parts.push_back(j);
+                for (int k = 0; k < problem.dimensions; ++k) {
+                    used[k] += problem.weight(k, j);
+                }
+                break;
+            }
+        }
+    }
+    Solution solution = extended_solution(problem, parts);
+    solution.upper_bound = extended_upper_bound(problem, 0, 0, std::vector<int>(problem.dimensions, 0).data());
+    return solution;
+}
+
+// ввод имени файла в обобщенном формате, как input_data для обычной задачи
+inline bool input_extended(ExtendedInstance& instance) {
+    std::string filename;
+    std::cout << "Enter input filename (n d, d capacities, n lines \"price weights bound group\"): ";
+    std::getline(std::cin, filename);
+    return load_extended_instance(filename, instance);
+}
+
+// --extended: входные данные в обобщенном формате (для программ branch_bound и dynamic_programming)
+inline bool parse_extended_arguments(int& argc, char* argv[], bool& extended) {
+    int kept = 1;
+    for (int i = 1; i < argc; ++i) {
+        if (std::string(argv[i]) == "--extended") {
+            extended = true;
+        } else {
+            argv[kept++] = argv[i];
+        }
+    }
+    argc = kept;
+    return true;
+}
+
+// решение обобщенной задачи в программе решателя: срок и отмена берутся из параметров solver, solve(problem, solution, control) -> bool
+template <typename Solve>
+int run_extended(Solver& solver, Solve&& solve) {
+    ExtendedInstance instance;
+    ExtendedProblem problem;
+    if (!input_extended(instance)) {
+        return 1;
+    }
+    prepare_extended(instance, problem);
+    cancel_on_interrupt(solver);
+    SolveControl control(solver.time_limit, solver.cancelled);
+    Solution solution;
+    auto start = std::chrono::high_resolution_clock::now();
+    if (!solve(problem, solution, control)) {
+        return 1;
+    }
+    auto end = std::chrono::high_resolution_clock::now();
+    print_solution(solution, end - start);
+    wait_for_exit();
+    return 0;
+}
\ No newline at end of file
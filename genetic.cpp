@@ -2,228 +2,271 @@
 #include <fstream>
 #include <string>
 #include <vector>
-#include <unordered_set>
-#include <algorithm>
 #include <random>
-#include <ctime>
 #include <chrono>
-
-#define POPULATION_SIZE 800 // размер популяции (число особей определяет разнообразие решений в каждом поколении)
-#define GENERATIONS 100 // число поколений - определяет время жизни популяции, чем больше, тем больше шансов получить хорошее решение
-#define MUTATION_RATE 0.1 // вероятность мутации - мутация позволяет выпрыгнуть из локального экстремума, но мутации не должны быть слишком частыми, чтобы решение сходилось. При частых мутациях решение будет слабо отличаться от случайного
-#define BATTLE_SIZE 18 // число особей, участвующих в "битве" - имитация естественного отбора и борьбы за выживание
-#define TOURNAMENT_SIZE 100 // число особей, участвующих в борьбе за выбор родителя
+#include <atomic>
+#include <cstdlib>
+#include <new>
+#include "genetic.h"
 
 using namespace std;
+using namespace genetic;
 
-mt19937 random_generator((random_device())());
+#if defined(BENCHMARK)
+atomic<long long> allocations_count(0); // счетчик выделений памяти через new
 
-bool generate_random_bool() noexcept {
-    return static_cast<bool>(random_generator() & 1);
+// все формы new и delete заменяются вместе, иначе память из незамененной формы освобождалась бы через free
+void* allocate(size_t size, size_t alignment = 0) {
+    allocations_count.fetch_add(1, memory_order_relaxed);
+    size = size == 0 ? 1 : size;
+    void* pointer = alignment == 0 ? malloc(size) : aligned_alloc(alignment, (size + alignment - 1) / alignment * alignment);
+    if (pointer == nullptr) {
+        throw bad_alloc();
+    }
+    return pointer;
 }
 
-unsigned int random_unsigned_int() noexcept {
-    return random_generator();
+void* operator new(size_t size) {
+    return allocate(size);
 }
 
-double random_double(double a, double b) noexcept {
-    return uniform_real_distribution<double>(0, 1)(random_generator);
+void* operator new[](size_t size) {
+    return allocate(size);
 }
 
-struct Item {
-    int price;
-    int weight;
-};
-
-// особь
-struct Individual {
-    vector<bool> DNA; // ДНК - это какие предметы взяты в рюкзак
-    int fitness; // приспособленность к выживанию - это суммарная стоимость, если вес не превышает максимального, или 0 в противном случае
-
-    Individual(int max_weight, const vector<Item>& items, const vector<bool>& individual_dna) noexcept :
-        DNA(individual_dna),
-        fitness(0) {
-        int price = 0;
-        int weight = 0;
-        for (int i = 0; i < items.size(); ++i) {
-            if (DNA[i]) {
-                price += items[i].price;
-                weight += items[i].weight;
-            }
-        }
+void* operator new(size_t size, align_val_t alignment) {
+    return allocate(size, static_cast<size_t>(alignment));
+}
 
-        if (weight <= max_weight) {
-            fitness = price;
-        }
-    }
-};
+void* operator new[](size_t size, align_val_t alignment) {
+    return allocate(size, static_cast<size_t>(alignment));
+}
 
-Individual create_random_individual(int max_weight, const vector<Item>& items) noexcept {
-    vector<bool> individual_dna(items.size());
-    for (int i = 0; i < items.size(); ++i) {
-        individual_dna[i] = generate_random_bool();
-    }
-    return Individual(max_weight, items, individual_dna);
+void operator delete(void* pointer) noexcept {
+    free(pointer);
 }
 
-/*
-Естественный отбор, борьба за выживание.
-Не используется в алгоритме, так как она снижает рождаемость.
-Для использования нужно повысить рождаемость или оставлять родителей в новой популяции.
-В первом случае нужно будет сильно увеличивать число поколений, и алгоритм будет работать дольше.
-Во втором случае для сходимости придется ввести индекс поколения и убирать из популяции особей, которые прожили несколько поколений (например, 3).
-*/
-vector<Individual> natural_selection(const vector<Individual>& population) noexcept {
-    vector<Individual> survivors; // выжившие после борьбы особи
-    unordered_set<unsigned int> victims_indices; // уже рассмотренные особи, включая наиболее приспособленную
-    auto next_victim = [&]() {
-        unsigned int victim_index;
-        do {
-            victim_index = random_unsigned_int() % population.size();
-        } while (victims_indices.contains(victim_index)); // не сражаемся с самим собой и не повторяемся в процессе борьбы - мертвые не встают
-        victims_indices.insert(victim_index); // добавляем новую жертву
-        return population[victim_index];
-    };
-
-    Individual best = next_victim();
-    for (int i = 1; i < BATTLE_SIZE; ++i) {
-        Individual victim = next_victim();
-        if (best.fitness < victim.fitness) {
-            best = victim; // обновляем "царя горы"
-        }
-    }
+void operator delete[](void* pointer) noexcept {
+    free(pointer);
+}
 
-    survivors.push_back(best); // добавляем "царя горы" к выжившим особям
-    for (int i = 0; i < population.size(); ++i) {
-        if (!victims_indices.contains(i)) {
-            survivors.push_back(population[i]);
-        }
-    }
-    return survivors;
+void operator delete(void* pointer, size_t) noexcept {
+    free(pointer);
 }
 
-// борьба за выбор родителя
-Individual tournament_selection(const vector<Individual>& population) noexcept {
-    auto next_challenger = [&]() {
-        return population[random_unsigned_int() % population.size()];
-    };
-    Individual best = next_challenger();
-    for (int i = 1; i < TOURNAMENT_SIZE; ++i) {
-        Individual challenger = next_challenger();
-        if (best.fitness < challenger.fitness) {
-            best = challenger;
-        }
-    }
-    return best;
+void operator delete[](void* pointer, size_t) noexcept {
+    free(pointer);
 }
 
-vector<bool> mutate_dna(vector<bool> dna) noexcept {
-    for (int i = 0; i < dna.size(); ++i) {
-        if (random_double(0, 1) < MUTATION_RATE) {
-            dna[i] = !dna[i];
-        }
-    }
-    return dna;
+void operator delete(void* pointer, align_val_t) noexcept {
+    free(pointer);
+}
+
+void operator delete[](void* pointer, align_val_t) noexcept {
+    free(pointer);
 }
 
-pair<Individual, Individual> crossover(int max_weight, const vector<Item> items, const Individual& mother, const Individual& father) noexcept {
-    vector<bool> son_dna(items.size());
-    vector<bool> daughter_dna(items.size());
-    for (int i = 0; i < items.size(); ++i) {
-        if (generate_random_bool()) {
-            son_dna[i] = father.DNA[i];
-            daughter_dna[i] = mother.DNA[i];
-        } else {
-            son_dna[i] = mother.DNA[i];
-            daughter_dna[i] = father.DNA[i];
+void operator delete(void* pointer, size_t, align_val_t) noexcept {
+    free(pointer);
+}
+
+void operator delete[](void* pointer, size_t, align_val_t) noexcept {
+    free(pointer);
+}
+
+// прежняя оценка особи: побитовый цикл с ветвлением по vector<bool> и массиву структур
+void evaluate_vector_bool(const vector<Item>& items, const vector<bool>& dna, long long& price, long long& weight) noexcept {
+    price = 0;
+    weight = 0;
+    for (size_t i = 0; i < items.size(); ++i) {
+        if (dna[i]) {
+            price += items[i].price;
+            weight += items[i].weight;
         }
     }
-    return {
-        Individual(max_weight, items, mutate_dna(son_dna)),
-        Individual(max_weight, items, mutate_dna(daughter_dna))
-    };
 }
 
-int solve(int max_weight, const vector<Item>& items) noexcept {
-    vector<Individual> population;
-    for (int i = 0; i < POPULATION_SIZE; ++i) {
-        population.push_back(create_random_individual(max_weight, items));
-    }
+// число оценок особей в секунду (vector<bool> против упакованной ДНК), выделения памяти в цикле поколений и скорость специализированных версий поколения
+void benchmark() {
+    constexpr int individuals = 16;
+    cout << "n\tvector<bool> evaluations/sec\tpacked evaluations/sec\tspeedup\tsame sums\n";
+    for (int n : {10000, 100000, 1000000}) {
+        mt19937 generator(n);
+        uniform_int_distribution<int> distribution(1, 1000);
+        vector<Item> items(n);
+        for (auto& item : items) {
+            item.price = distribution(generator);
+            item.weight = distribution(generator);
+        }
+        Instance instance;
+        prepare_instance(0, items, instance);
+        ItemArrays item_arrays(instance);
 
-    for (int generation = 0; generation < GENERATIONS; ++generation) {
-        vector<Individual> new_population;
-        while (new_population.size() < POPULATION_SIZE) {
-            Individual mother = tournament_selection(population);
-            Individual father = tournament_selection(population);
+        vector<vector<bool>> bool_dnas(individuals, vector<bool>(n));
+        vector<vector<uint64_t>> packed_dnas(individuals, vector<uint64_t>(item_arrays.words, 0));
+        for (int k = 0; k < individuals; ++k) {
+            for (int i = 0; i < n; ++i) {
+                bool bit = generator() & 1;
+                bool_dnas[k][i] = bit;
+                packed_dnas[k][i / WORD_BITS] |= static_cast<uint64_t>(bit) << (i % WORD_BITS);
+            }
+        }
 
-            auto [son, daughter] = crossover(max_weight, items, mother, father);
-            new_population.push_back(son);
-            new_population.push_back(daughter);
+        int repetitions = max(1, 100'000'000 / n);
+        long long bool_checksum = 0, packed_checksum = 0;
+        auto start = chrono::high_resolution_clock::now();
+        for (int r = 0; r < repetitions; ++r) {
+            for (const auto& dna : bool_dnas) {
+                long long price, weight;
+                evaluate_vector_bool(items, dna, price, weight);
+                bool_checksum += price + weight;
+            }
         }
-        population = move(new_population);
-    }
+        double bool_seconds = chrono::duration<double>(chrono::high_resolution_clock::now() - start).count();
 
-    int best_price = 0;
-    for (const auto& individual : population) {
-        best_price = max(best_price, individual.fitness);
-    }
-    return best_price;
-}
+        start = chrono::high_resolution_clock::now();
+        for (int r = 0; r < repetitions; ++r) {
+            for (const auto& dna : packed_dnas) {
+                long long price, weight;
+                evaluate(item_arrays, dna.data(), price, weight);
+                packed_checksum += price + weight;
+            }
+        }
+        double packed_seconds = chrono::duration<double>(chrono::high_resolution_clock::now() - start).count();
 
-vector<Item> manual_input(int& n, int& max_weight) noexcept {
-    cout << "Input number of items: ";
-    cin >> n;
-    cout << "Input max backpack weight: ";
-    cin >> max_weight;
-    cout << "Input n pairs: price - weight\n";
-    vector<Item> items(n);
-    for (int i = 0; i < n; ++i) {
-        cin >> items[i].price >> items[i].weight;
+        double evaluations = static_cast<double>(repetitions) * individuals;
+        cout << n << '\t' << static_cast<long long>(evaluations / bool_seconds) << '\t' << static_cast<long long>(evaluations / packed_seconds) << '\t'
+            << bool_seconds / packed_seconds << '\t' << (bool_checksum == packed_checksum ? "yes" : "no") << '\n';
     }
-    return items;
-}
-
-vector<Item> file_input(int& n, int& max_weight, const string& filename) {
-    ifstream file(filename);
-    if (!file.is_open()) {
-        cerr << "Error: can't open the file '" << filename << "'.\n";
-        return {};
+    // цикл поколений: буферы популяции создаются один раз, поэтому выделений памяти в цикле быть не должно
+    constexpr int generations = 10;
+    cout << "\nn\tgenerations/sec\tallocations in generations loop\n";
+    for (int n : {1000, 10000}) {
+        mt19937 generator(n);
+        uniform_int_distribution<int> distribution(1, 1000);
+        vector<Item> items(n);
+        long long total_weight = 0;
+        for (auto& item : items) {
+            item.price = distribution(generator);
+            item.weight = distribution(generator);
+            total_weight += item.weight;
+        }
+        int max_weight = static_cast<int>(total_weight / 2);
+        Instance instance;
+        prepare_instance(max_weight, items, instance);
+        ItemArrays item_arrays(instance);
+        Parameters parameters;
+        Population population(parameters.population_size, item_arrays.words);
+        Population new_population(parameters.population_size, item_arrays.words);
+        RandomGenerator random_generator(n);
+        for (int i = 0; i < parameters.population_size; ++i) {
+            create_random_individual(max_weight, item_arrays, population, i, random_generator);
+        }
+        GenerationKernel next_generation_kernel = select_generation_kernel(item_arrays.words, parameters.tournament_size);
+        long long allocations_before = allocations_count.load();
+        auto start = chrono::high_resolution_clock::now();
+        for (int generation = 0; generation < generations; ++generation) {
+            next_generation_kernel(max_weight, item_arrays, parameters, population, new_population, random_generator);
+            swap(population, new_population);
+        }
+        double seconds = chrono::duration<double>(chrono::high_resolution_clock::now() - start).count();
+        cout << n << '\t' << generations / seconds << '\t' << allocations_count.load() - allocations_before << '\n';
     }
 
-    file >> n >> max_weight;
-    vector<Item> items(n);
-    for (int i = 0; i < n; ++i) {
-        file >> items[i].price >> items[i].weight;
+    /*
+    Специализированные версии next_generation против общей (число слов и размер турнира известны только при выполнении)
+    и против версии только с размером турнира при компиляции - так было, когда параметры задавались макросами.
+    Зерно одинаковое, поэтому все версии должны прийти к одной и той же популяции.
+    */
+    cout << "\nn\twords\ttournament\tgeneric generations/sec\tmacro-like generations/sec\tspecialized generations/sec\tspeedup\tsame result\n";
+    for (int tournament_size : {TOURNAMENT_SIZE, 4}) {
+        for (int n : {64, 128, 256, 300, 512, 1024}) {
+            mt19937 generator(n);
+            uniform_int_distribution<int> distribution(1, 1000);
+            vector<Item> items(n);
+            long long total_weight = 0;
+            for (auto& item : items) {
+                item.price = distribution(generator);
+                item.weight = distribution(generator);
+                total_weight += item.weight;
+            }
+            int max_weight = static_cast<int>(total_weight / 2);
+            Instance instance;
+            prepare_instance(max_weight, items, instance);
+            ItemArrays item_arrays(instance);
+            Parameters parameters;
+            parameters.tournament_size = tournament_size;
+            auto measure = [&](GenerationKernel kernel, long long& checksum) { // лучшее из 3 запусков, чтобы уменьшить шум
+                double best_speed = 0;
+                for (int run = 0; run < 3; ++run) {
+                    Population population(parameters.population_size, item_arrays.words);
+                    Population new_population(parameters.population_size, item_arrays.words);
+                    RandomGenerator random_generator(n);
+                    for (int i = 0; i < parameters.population_size; ++i) {
+                        create_random_individual(max_weight, item_arrays, population, i, random_generator);
+                    }
+                    auto start = chrono::high_resolution_clock::now();
+                    for (int generation = 0; generation < generations * 10; ++generation) {
+                        kernel(max_weight, item_arrays, parameters, population, new_population, random_generator);
+                        swap(population, new_population);
+                    }
+                    double seconds = chrono::duration<double>(chrono::high_resolution_clock::now() - start).count();
+                    best_speed = max(best_speed, generations * 10 / seconds);
+                    checksum = 0;
+                    for (long long fitness : population.fitness) {
+                        checksum += fitness;
+                    }
+                }
+                return best_speed;
+            };
+            long long generic_checksum, macro_checksum, specialized_checksum;
+            double generic_speed = measure(next_generation<0, 0>, generic_checksum);
+            double macro_speed = measure(tournament_size == TOURNAMENT_SIZE ? next_generation<0, TOURNAMENT_SIZE> : next_generation<0, 0>, macro_checksum);
+            double specialized_speed = measure(select_generation_kernel(item_arrays.words, tournament_size), specialized_checksum);
+            cout << n << '\t' << item_arrays.words << '\t' << tournament_size << '\t' << generic_speed << '\t' << macro_speed << '\t' << specialized_speed << '\t'
+                << specialized_speed / macro_speed << '\t' << (generic_checksum == macro_checksum && macro_checksum == specialized_checksum ? "yes" : "no") << '\n';
+        }
     }
-    return items;
 }
+#endif
 
-vector<Item> input_data(int& n, int& max_weight) {
-    string filename;
-    cout << "Enter input filename or press Enter to manually input data: ";
-    getline(cin, filename);
-    if (filename.empty()) {
-        return manual_input(n, max_weight);
+// Аргументы командной строки: --config=файл и --имя=значение (например, --population_size=1000 --seed=42), см. Parameters
+int main(int argc, char* argv[]) {
+#if defined(BENCHMARK)
+    benchmark();
+    return 0;
+#endif
+    GeneticSolver solver;
+    solver.parameters.seed = (random_device())();
+    BatchOptions batch;
+    StatisticsOptions statistics;
+    if (!parse_batch_arguments(argc, argv, batch) || !parse_statistics_arguments(argc, argv, statistics) || !parse_arguments({&solver}, argc, argv)) {
+        return 1;
     }
-    return file_input(n, max_weight, filename);
-}
-
-int main() {
-    int n, max_weight;
-    vector<Item> items = input_data(n, max_weight);
+    Instrumentation instrumentation;
+    StatisticsReporter reporter(instrumentation, statistics); // выводит статистику, только если она запрошена
+    if (statistics.enabled) {
+        solver.instrumentation = &instrumentation;
+    }
+    if (batch.source != BatchSource::none) {
+        cerr << "Seed: " << solver.parameters.seed << '\n'; // все задачи решаются с одним зерном: ответ не зависит от порядка и потока решения
+        return run_batch(batch, solver);
+    }
+    Instance instance;
+    if (!input_data(instance)) {
+        return 1;
+    }
+    cancel_on_interrupt(solver);
     auto start = chrono::high_resolution_clock::now();
-    int best_price = solve(max_weight, items);
+    ReductionStatistics reduction;
+    Solution solution = solver.solve(instance, &reduction);
     auto end = chrono::high_resolution_clock::now();
-    auto time_spent = end - start;
-    cout << "Maximum price that can be taken: " << best_price << '\n';
-    cout << "Time spent:\n";
-    cout << "t = " << time_spent.count() << " nanoseconds\n";
-    cout << "t ~ " << chrono::duration_cast<chrono::milliseconds>(time_spent).count() << " milliseconds\n";
-    cout << "t ~ " << chrono::duration_cast<chrono::seconds>(time_spent).count() << " seconds\n";
-#if defined(NDEBUG)
-    std::cout << "Press Enter to exit...";
-    std::cin.ignore();
-    std::cin.get();
-#endif
+    reporter.stop();
+    cout << "Seed: " << solver.parameters.seed << '\n';
+    if (solver.reduction) {
+        print_reduction(reduction);
+    }
+    print_solution(solution, end - start);
+    wait_for_exit();
     return 0;
 }
\ No newline at end of file
@@ -0,0 +1,216 @@
+#pragma once
+
+#include <vector>
+#include <unordered_set>
+#include <algorithm>
+#include <cstdint>
+#include "knapsack.h"
+#include "genetic_common.h"
+
+namespace genetic {
+
+using namespace genetic_common;
+
+inline void create_random_individual(int max_weight, const ItemArrays& items, Population& population, int i, RandomGenerator& generator) noexcept {
+    uint64_t* dna = population.dna(i);
+    for (int w = 0; w < items.words; ++w) {
+        dna[w] = random_word(generator);
+    }
+    dna[items.words - 1] &= items.last_word_mask;
+    population.update_fitness(i, max_weight, items);
+}
+
+/*
+Естественный отбор, борьба за выживание.
+Не используется в алгоритме, так как она снижает рождаемость.
+Для использования нужно повысить рождаемость или оставлять родителей в новой популяции.
+В первом случае нужно будет сильно увеличивать число поколений, и алгоритм будет работать дольше.
+Во втором случае для сходимости придется ввести индекс поколения и убирать из популяции особей, которые прожили несколько поколений (например, 3).
+*/
+// возвращает индексы выживших особей
+inline std::vector<int> natural_selection(const Population& population, int battle_size, RandomGenerator& generator) noexcept {
+    std::vector<int> survivors; // выжившие после борьбы особи
+    std::unordered_set<unsigned int> victims_indices; // уже рассмотренные особи, включая наиболее приспособленную
+    auto next_victim = [&]() {
+        unsigned int victim_index;
+        do {
+            victim_index = random_index(generator, population.size);
+        } while (victims_indices.contains(victim_index)); // не сражаемся с самим собой и не повторяемся в процессе борьбы - мертвые не встают
+        victims_indices.insert(victim_index); // добавляем новую жертву
+        return static_cast<int>(victim_index);
+    };
+
+    int best = next_victim();
+    for (int i = 1; i < battle_size; ++i) {
+        int victim = next_victim();
+        if (population.fitness[best] < population.fitness[victim]) {
+            best = victim; // обновляем "царя горы"
+        }
+    }
+
+    survivors.push_back(best); // добавляем "царя горы" к выжившим особям
+    for (int i = 0; i < population.size; ++i) {
+        if (!victims_indices.contains(i)) {
+            survivors.push_back(i);
+        }
+    }
+    return survivors;
+}
+
+/*
+Равномерное скрещивание: случайная маска определяет, от кого из родителей сын получает ген, дочь получает ген от другого.
+Сын записывается в children на место son, дочь - на место son + 1 (если оно есть).
+*/
+template<int Words = 0>
+void crossover(int max_weight, const ItemArrays& items, double mutation_rate, const Population& parents, int mother, int father, Population& children, int son, RandomGenerator& generator) noexcept {
+    const int words = Words > 0 ? Words : items.words;
+    const uint64_t* mother_dna = parents.dna(mother);
+    const uint64_t* father_dna = parents.dna(father);
+    bool has_daughter = son + 1 < children.size;
+    uint64_t* son_dna = children.dna(son);
+    uint64_t* daughter_dna = has_daughter ? children.dna(son + 1) : nullptr;
+    for (int w = 0; w < words; ++w) {
+        uint64_t from_father = random_word(generator);
+        son_dna[w] = (father_dna[w] & from_father) | (mother_dna[w] & ~from_father);
+        if (has_daughter) {
+            daughter_dna[w] = (mother_dna[w] & from_father) | (father_dna[w] & ~from_father);
+        }
+    }
+
+    mutate_dna(son_dna, items.size, mutation_rate, generator);
+    children.update_fitness<Words>(son, max_weight, items);
+    if (has_daughter) {
+        mutate_dna(daughter_dna, items.size, mutation_rate, generator);
+        children.update_fitness<Words>(son + 1, max_weight, items);
+    }
+}
+
+// параметры алгоритма: по умолчанию берутся из макросов, меняются из командной строки и файла настроек без перекомпиляции
+struct Parameters {
+    int population_size = POPULATION_SIZE;
+    int generations = GENERATIONS;
+    double mutation_rate = MUTATION_RATE;
+    int battle_size = BATTLE_SIZE;
+    int tournament_size = TOURNAMENT_SIZE;
+    int stagnation_generations = STAGNATION_GENERATIONS;
+    uint64_t seed = 0; // зерно генератора: при одинаковом зерне результат одинаковый
+};
+
+// новое поколение записывается в new_population; выделений памяти нет
+template<int Words = 0, int TournamentSize = 0>
+void next_generation(int max_weight, const ItemArrays& items, const Parameters& parameters, const Population& population, Population& new_population, RandomGenerator& generator) noexcept {
+    for (int i = 0; i < new_population.size; i += 2) {
+        int mother = tournament_selection<TournamentSize>(population, parameters.tournament_size, generator);
+        int father = tournament_selection<TournamentSize>(population, parameters.tournament_size, generator);
+        crossover<Words>(max_weight, items, parameters.mutation_rate, population, mother, father, new_population, i, generator);
+    }
+}
+
+using GenerationKernel = void (*)(int, const ItemArrays&, const Parameters&, const Population&, Population&, RandomGenerator&) noexcept;
+
+// next_generation как параметр шаблона genetic_common::select_generation_kernel
+template<int Words, int TournamentSize>
+struct NextGeneration {
+    static constexpr GenerationKernel kernel = next_generation<Words, TournamentSize>;
+};
+
+// см. genetic_common::select_generation_kernel
+inline GenerationKernel select_generation_kernel(int words, int tournament_size) noexcept {
+    return genetic_common::select_generation_kernel<NextGeneration>(words, tournament_size);
+}
+
+// instrumentation - если не nullptr, сюда пишутся счетчики поколений (см. instrumentation.h)
+// control - срок, отмена и обратный вызов для рекордов; проверяется после каждого поколения
+inline Solution solve(const Instance& instance, const Parameters& parameters, Instrumentation* instrumentation = nullptr, SolveControl* control = nullptr) noexcept {
+    if (instance.count == 0) {
+        return {0, {}};
+    }
+    PhaseTimer phase(instrumentation, Phase::initialization);
+    ThreadProbe probe(instrumentation);
+    const int max_weight = instance.max_weight;
+    RandomGenerator generator(parameters.seed);
+    ItemArrays item_arrays(instance);
+    Population population(parameters.population_size, item_arrays.words);
+    Population new_population(parameters.population_size, item_arrays.words); // второй буфер: поколения пишутся в него и меняются местами с population
+    for (int i = 0; i < parameters.population_size; ++i) {
+        create_random_individual(max_weight, item_arrays, population, i, generator);
+    }
+    if (control != nullptr) {
+        seed_population(max_weight, item_arrays, population, control->seeds());
+    }
+
+    GenerationKernel next_generation_kernel = select_generation_kernel(item_arrays.words, parameters.tournament_size);
+    BestIndividual best(item_arrays.words);
+    best.update(population, item_arrays, control);
+    bool stopped = false;
+    phase.next(Phase::search);
+    for (int generation = 0, stagnation = 0; generation < parameters.generations; ++generation) {
+        next_generation_kernel(max_weight, item_arrays, parameters, population, new_population, generator);
+        std::swap(population, new_population);
+        probe.generation(population.fitness);
+        if (best.update(population, item_arrays, control)) {
+            stagnation = 0;
+        } else if (0 < parameters.stagnation_generations && parameters.stagnation_generations <= ++stagnation) {
+            break; // лучшая особь давно не улучшается
+        }
+        if (control != nullptr && control->stop_requested()) {
+            stopped = generation + 1 < parameters.generations;
+            break;
+        }
+    }
+
+    phase.next(Phase::reconstruction);
+    if (control != nullptr && control->collects_pool()) {
+        export_population(population, item_arrays, *control);
+    }
+    Solution solution = best.solution(item_arrays);
+    solution.stopped = stopped;
+    return solution;
+}
+
+// один параметр по имени
+inline ParameterStatus set_parameter(Parameters& parameters, const std::string& name, const std::string& value) noexcept {
+    bool parsed;
+    if (name == "population_size") {
+        parsed = parse_number(value, parameters.population_size) && 0 < parameters.population_size;
+    } else if (name == "generations") {
+        parsed = parse_number(value, parameters.generations) && 0 <= parameters.generations;
+    } else if (name == "mutation_rate") {
+        parsed = parse_number(value, parameters.mutation_rate) && 0 <= parameters.mutation_rate && parameters.mutation_rate <= 1;
+    } else if (name == "battle_size") {
+        parsed = parse_number(value, parameters.battle_size) && 0 < parameters.battle_size;
+    } else if (name == "tournament_size") {
+        parsed = parse_number(value, parameters.tournament_size) && 0 < parameters.tournament_size;
+    } else if (name == "stagnation_generations") {
+        parsed = parse_number(value, parameters.stagnation_generations) && 0 <= parameters.stagnation_generations;
+    } else if (name == "seed") {
+        parsed = parse_number(value, parameters.seed);
+    } else {
+        return ParameterStatus::unknown;
+    }
+    return parsed ? ParameterStatus::applied : ParameterStatus::invalid;
+}
+
+class GeneticSolver : public Solver {
+public:
+    Parameters parameters;
+
+    const char* name() const noexcept override {
+        return "genetic";
+    }
+
+    const char* check_parameters() const noexcept override {
+        return parameters.population_size < parameters.battle_size ? "battle_size can't exceed population_size." : nullptr;
+    }
+
+protected:
+    Solution solve_instance(const Instance& instance, SolveControl& control) const override {
+        return genetic::solve(instance, parameters, instrumentation, &control);
+    }
+
+    ParameterStatus set_solver_parameter(const std::string& name, const std::string& value) override {
+        return genetic::set_parameter(parameters, name, value);
+    }
+};
+
+}
\ No newline at end of file
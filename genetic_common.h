@@ -0,0 +1,353 @@
+#pragma once
+
+/*
+Общая часть последовательного (genetic.h) и параллельного (parallel_genetic.h) ГА: генератор случайных чисел,
+упакованная ДНК и ее оценка, популяция, теплый старт, лучшая особь, турнирный отбор, мутация и выбор
+специализированной версии поколения. Алгоритм поколения, параметры и solve у каждого ГА свои.
+*/
+
+#include <vector>
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#if defined(__AVX2__) || defined(__SSE2__)
+#include <immintrin.h>
+#endif
+#include "knapsack.h"
+
+// значения параметров по умолчанию, без перекомпиляции меняются через Parameters (командная строка и файл настроек)
+#define POPULATION_SIZE 800 // размер популяции (число особей определяет разнообразие решений в каждом поколении)
+#define GENERATIONS 100 // число поколений - определяет время жизни популяции, чем больше, тем больше шансов получить хорошее решение
+#define MUTATION_RATE 0.1 // вероятность мутации - мутация позволяет выпрыгнуть из локального экстремума, но мутации не должны быть слишком частыми, чтобы решение сходилось. При частых мутациях решение будет слабо отличаться от случайного
+#define BATTLE_SIZE 18 // число особей, участвующих в "битве" - имитация естественного отбора и борьбы за выживание
+#define TOURNAMENT_SIZE 100 // число особей, участвующих в борьбе за выбор родителя
+#define STAGNATION_GENERATIONS 0 // через сколько поколений без улучшения лучшей особи алгоритм (остров) останавливается; 0 - не останавливается
+
+namespace genetic_common {
+
+// splitmix64: перемешивает 64-битное число, используется для получения зерен из одного пользовательского зерна
+inline uint64_t splitmix64(uint64_t x) noexcept {
+    x += 0x9e3779b97f4a7c15ull;
+    x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9ull;
+    x = (x ^ (x >> 27)) * 0x94d049bb133111ebull;
+    return x ^ (x >> 31);
+}
+
+// xoshiro256++: быстрый генератор (4 слова состояния, без выделений памяти), удовлетворяет UniformRandomBitGenerator
+struct Xoshiro256 {
+    using result_type = uint64_t;
+
+    uint64_t state[4];
+
+    explicit Xoshiro256(uint64_t seed) noexcept {
+        for (auto& word : state) {
+            seed = splitmix64(seed);
+            word = seed;
+        }
+    }
+
+    static constexpr result_type min() noexcept {
+        return 0;
+    }
+
+    static constexpr result_type max() noexcept {
+        return ~0ull;
+    }
+
+    static uint64_t rotate_left(uint64_t x, int k) noexcept {
+        return (x << k) | (x >> (64 - k));
+    }
+
+    result_type operator()() noexcept {
+        uint64_t result = rotate_left(state[0] + state[3], 23) + state[0];
+        uint64_t t = state[1] << 17;
+        state[2] ^= state[0];
+        state[3] ^= state[1];
+        state[1] ^= state[2];
+        state[0] ^= state[3];
+        state[2] ^= t;
+        state[3] = rotate_left(state[3], 45);
+        return result;
+    }
+};
+
+using RandomGenerator = Xoshiro256; // генератор можно заменить любым UniformRandomBitGenerator с 64-битным результатом (например, mt19937_64)
+
+inline uint64_t random_word(RandomGenerator& generator) noexcept {
+    return generator();
+}
+
+// случайное число из [0, size) умножением старших 32 бит вместо деления с остатком
+inline unsigned int random_index(RandomGenerator& generator, unsigned int size) noexcept {
+    return static_cast<unsigned int>(((generator() >> 32) * size) >> 32);
+}
+
+// случайное число из [0, 1)
+inline double random_double(RandomGenerator& generator) noexcept {
+    return (generator() >> 11) * 0x1.0p-53;
+}
+
+constexpr int WORD_BITS = 64; // число генов в одном слове ДНК
+
+/*
+Предметы в виде структуры массивов: стоимости и веса лежат подряд 64-битными числами (сумма 32-битных стоимостей
+может не поместиться в int) и дополнены нулями до целого числа слов ДНК, поэтому сумма по маске генов считается
+блоками по 4 (AVX2) или 2 (SSE2) предмета без проверок выхода за границу.
+*/
+struct ItemArrays {
+    int size; // число предметов
+    int words; // число слов ДНК
+    uint64_t last_word_mask; // значащие биты последнего слова
+    std::vector<long long> prices;
+    std::vector<long long> weights;
+
+    explicit ItemArrays(const Instance& instance) noexcept :
+        size(instance.count),
+        words((size + WORD_BITS - 1) / WORD_BITS),
+        last_word_mask(size % WORD_BITS == 0 ? ~0ull : (1ull << (size % WORD_BITS)) - 1),
+        prices(static_cast<size_t>(words) * WORD_BITS, 0),
+        weights(static_cast<size_t>(words) * WORD_BITS, 0) {
+        std::copy(instance.prices.begin(), instance.prices.end(), prices.begin());
+        std::copy(instance.weights.begin(), instance.weights.end(), weights.begin());
+    }
+};
+
+inline bool gene(const uint64_t* dna, int i) noexcept {
+    return (dna[i / WORD_BITS] >> (i % WORD_BITS)) & 1;
+}
+
+// суммарные стоимость и вес предметов, отмеченных в ДНК; Words > 0 - число слов ДНК известно при компиляции, 0 - берется из items
+template<int Words = 0>
+void evaluate(const ItemArrays& items, const uint64_t* dna, long long& price, long long& weight) noexcept {
+    const int words = Words > 0 ? Words : items.words;
+#if defined(__AVX2__)
+    const __m256i bits = _mm256_setr_epi64x(1, 2, 4, 8);
+    __m256i prices = _mm256_setzero_si256();
+    __m256i weights = _mm256_setzero_si256();
+    for (int w = 0; w < words; ++w) {
+        uint64_t word = dna[w];
+        if (word == 0) {
+            continue;
+        }
+        const long long* word_prices = items.prices.data() + w * WORD_BITS;
+        const long long* word_weights = items.weights.data() + w * WORD_BITS;
+        for (int nibble = 0; nibble < WORD_BITS / 4; ++nibble, word >>= 4) { // 4 гена -> маска из 4 чисел
+            __m256i mask = _mm256_and_si256(_mm256_set1_epi64x(static_cast<long long>(word & 0xf)), bits);
+            mask = _mm256_cmpeq_epi64(mask, bits);
+            prices = _mm256_add_epi64(prices, _mm256_and_si256(mask, _mm256_loadu_si256(reinterpret_cast<const __m256i*>(word_prices + nibble * 4))));
+            weights = _mm256_add_epi64(weights, _mm256_and_si256(mask, _mm256_loadu_si256(reinterpret_cast<const __m256i*>(word_weights + nibble * 4))));
+        }
+    }
+    alignas(32) long long price_lanes[4], weight_lanes[4];
+    _mm256_store_si256(reinterpret_cast<__m256i*>(price_lanes), prices);
+    _mm256_store_si256(reinterpret_cast<__m256i*>(weight_lanes), weights);
+    price = price_lanes[0] + price_lanes[1] + price_lanes[2] + price_lanes[3];
+    weight = weight_lanes[0] + weight_lanes[1] + weight_lanes[2] + weight_lanes[3];
+#elif defined(__SSE2__)
+    const __m128i bits = _mm_setr_epi32(1, 1, 2, 2); // 64-битного сравнения в SSE2 нет: обе половины числа сравниваются с одним битом
+    __m128i prices = _mm_setzero_si128();
+    __m128i weights = _mm_setzero_si128();
+    for (int w = 0; w < words; ++w) {
+        uint64_t word = dna[w];
+        if (word == 0) {
+            continue;
+        }
+        const long long* word_prices = items.prices.data() + w * WORD_BITS;
+        const long long* word_weights = items.weights.data() + w * WORD_BITS;
+        for (int pair = 0; pair < WORD_BITS / 2; ++pair, word >>= 2) { // 2 гена -> маска из 2 чисел
+            __m128i mask = _mm_and_si128(_mm_set1_epi32(static_cast<int>(word & 0x3)), bits);
+            mask = _mm_cmpeq_epi32(mask, bits);
+            prices = _mm_add_epi64(prices, _mm_and_si128(mask, _mm_loadu_si128(reinterpret_cast<const __m128i*>(word_prices + pair * 2))));
+            weights = _mm_add_epi64(weights, _mm_and_si128(mask, _mm_loadu_si128(reinterpret_cast<const __m128i*>(word_weights + pair * 2))));
+        }
+    }
+    alignas(16) long long price_lanes[2], weight_lanes[2];
+    _mm_store_si128(reinterpret_cast<__m128i*>(price_lanes), prices);
+    _mm_store_si128(reinterpret_cast<__m128i*>(weight_lanes), weights);
+    price = price_lanes[0] + price_lanes[1];
+    weight = weight_lanes[0] + weight_lanes[1];
+#else
+    price = 0;
+    weight = 0;
+    for (int w = 0; w < words; ++w) {
+        uint64_t word = dna[w];
+        if (word == 0) {
+            continue;
+        }
+        const long long* word_prices = items.prices.data() + w * WORD_BITS;
+        const long long* word_weights = items.weights.data() + w * WORD_BITS;
+        for (int bit = 0; bit < WORD_BITS; ++bit) { // без ветвлений: маска -1 или 0, цикл векторизуется компилятором
+            long long mask = -static_cast<long long>((word >> bit) & 1);
+            price += word_prices[bit] & mask;
+            weight += word_weights[bit] & mask;
+        }
+    }
+#endif
+}
+
+/*
+Популяция: ДНК всех особей лежит в одном массиве (особь i занимает слова [i * words, (i + 1) * words)),
+приспособленность - в отдельном. Память выделяется один раз, потомки записываются на место особей прошлого поколения.
+*/
+struct Population {
+    int size; // число особей
+    int words; // число слов ДНК одной особи
+    std::vector<uint64_t> DNA; // ДНК - это какие предметы взяты в рюкзак, по биту на предмет
+    std::vector<long long> fitness; // приспособленность к выживанию - это суммарная стоимость, если вес не превышает максимального, или 0 в противном случае
+
+    Population(int population_size, int dna_words) noexcept :
+        size(population_size),
+        words(dna_words),
+        DNA(static_cast<size_t>(population_size) * dna_words, 0),
+        fitness(population_size, 0) {}
+
+    uint64_t* dna(int i) noexcept {
+        return DNA.data() + static_cast<size_t>(i) * words;
+    }
+
+    const uint64_t* dna(int i) const noexcept {
+        return DNA.data() + static_cast<size_t>(i) * words;
+    }
+
+    template<int Words = 0>
+    void update_fitness(int i, int max_weight, const ItemArrays& items) noexcept {
+        long long price, weight;
+        evaluate<Words>(items, dna(i), price, weight);
+        fitness[i] = weight <= max_weight ? price : 0;
+    }
+};
+
+// решения теплого старта seeds[first], seeds[first + step], ... (см. SolveControl::seeds) заменяют первые особи популяции
+inline void seed_population(int max_weight, const ItemArrays& items, Population& population, const std::vector<std::vector<int>>& seeds,
+    size_t first = 0, size_t step = 1) noexcept {
+    int i = 0;
+    for (size_t k = first; k < seeds.size() && i < population.size; k += step, ++i) {
+        uint64_t* dna = population.dna(i);
+        std::fill(dna, dna + population.words, 0);
+        for (int item : seeds[k]) {
+            dna[item / WORD_BITS] |= 1ull << (item % WORD_BITS);
+        }
+        population.update_fitness(i, max_weight, items);
+    }
+}
+
+// допустимые особи последнего поколения - в пул для следующего теплого старта (SolveControl::collects_pool)
+inline void export_population(const Population& population, const ItemArrays& items, SolveControl& control) {
+    for (int i = 0; i < population.size; ++i) {
+        if (0 < population.fitness[i]) {
+            std::vector<int> chosen;
+            for (int j = 0; j < items.size; ++j) {
+                if (gene(population.dna(i), j)) {
+                    chosen.push_back(j);
+                }
+            }
+            control.add_to_pool(std::move(chosen));
+        }
+    }
+}
+
+// лучшая особь за все поколения: ответ - лучшее найденное решение, а не лучшая особь последнего поколения
+struct BestIndividual {
+    std::vector<uint64_t> dna;
+    long long fitness = -1; // -1 - еще не было ни одной особи
+
+    explicit BestIndividual(int words) noexcept :
+        dna(words, 0) {}
+
+    // true, если лучшая особь популяции лучше запомненной; новый рекорд передается control
+    bool update(const Population& population, const ItemArrays& items, SolveControl* control) noexcept {
+        int best = static_cast<int>(std::max_element(population.fitness.begin(), population.fitness.end()) - population.fitness.begin());
+        if (population.fitness[best] <= fitness) {
+            return false;
+        }
+        fitness = population.fitness[best];
+        std::copy(population.dna(best), population.dna(best) + population.words, dna.begin());
+        if (control != nullptr && control->publishes()) {
+            control->publish(solution(items));
+        }
+        return true;
+    }
+
+    Solution solution(const ItemArrays& items) const noexcept {
+        Solution solution{std::max(fitness, 0ll), {}};
+        if (0 < fitness) { // особь с нулевой приспособленностью может быть перегружена - тогда лучше не брать ничего
+            for (int i = 0; i < items.size; ++i) {
+                if (gene(dna.data(), i)) {
+                    solution.items.push_back(i);
+                }
+            }
+        }
+        return solution;
+    }
+};
+
+// борьба за выбор родителя, возвращает индекс победителя; TournamentSize > 0 - размер турнира известен при компиляции
+template<int TournamentSize = 0>
+int tournament_selection(const Population& population, int tournament_size, RandomGenerator& generator) noexcept {
+    const int size = TournamentSize > 0 ? TournamentSize : tournament_size;
+    auto next_challenger = [&]() {
+        return static_cast<int>(random_index(generator, population.size));
+    };
+    int best = next_challenger();
+    for (int i = 1; i < size; ++i) {
+        int challenger = next_challenger();
+        if (population.fitness[best] < population.fitness[challenger]) {
+            best = challenger;
+        }
+    }
+    return best;
+}
+
+/*
+Мутация: каждый ген меняется с вероятностью mutation_rate. Вместо случайного числа на каждый ген
+генерируются расстояния между меняющимися генами - они распределены геометрически,
+поэтому случайных чисел нужно в 1 / mutation_rate раз меньше.
+*/
+inline void mutate_dna(uint64_t* dna, int size, double mutation_rate, RandomGenerator& generator) noexcept {
+#if defined(__AVX2__)
+    _mm256_zeroupper(); // log из libm - SSE-код: с грязными после evaluate верхними половинами ymm он работает в разы медленнее
+#endif
+    if (mutation_rate <= 0) {
+        return;
+    }
+    const double log_keep = std::log1p(-mutation_rate); // логарифм вероятности, что ген не меняется
+    auto skip = [&]() { // сколько генов подряд не меняется
+        return log_keep < 0 ? static_cast<long long>(std::min(std::log(1 - random_double(generator)) / log_keep, static_cast<double>(size))) : 0;
+    };
+    for (long long i = skip(); i < size; i += 1 + skip()) {
+        dna[i / WORD_BITS] ^= 1ull << (i % WORD_BITS);
+    }
+}
+
+/*
+Версия next_generation, собранная под число слов ДНК и размер турнира: для частых значений (1, 2, 4, 8, 16 слов - до 1024 предметов;
+турнир TOURNAMENT_SIZE, 2 и 4) циклы разворачиваются при компиляции, для остальных используется общая версия.
+Kernel<Words, TournamentSize>::kernel - next_generation своего алгоритма (у genetic и parallel_genetic разные сигнатуры).
+*/
+template<template<int, int> typename Kernel, int Words>
+auto select_tournament_kernel(int tournament_size) noexcept {
+    if (tournament_size == TOURNAMENT_SIZE) {
+        return Kernel<Words, TOURNAMENT_SIZE>::kernel;
+    }
+    if (tournament_size == 2) {
+        return Kernel<Words, 2>::kernel;
+    }
+    if (tournament_size == 4) {
+        return Kernel<Words, 4>::kernel;
+    }
+    return Kernel<Words, 0>::kernel;
+}
+
+template<template<int, int> typename Kernel>
+auto select_generation_kernel(int words, int tournament_size) noexcept {
+    switch (words) {
+        case 1: return select_tournament_kernel<Kernel, 1>(tournament_size);
+        case 2: return select_tournament_kernel<Kernel, 2>(tournament_size);
+        case 4: return select_tournament_kernel<Kernel, 4>(tournament_size);
+        case 8: return select_tournament_kernel<Kernel, 8>(tournament_size);
+        case 16: return select_tournament_kernel<Kernel, 16>(tournament_size);
+        default: return select_tournament_kernel<Kernel, 0>(tournament_size);
+    }
+}
+
+}
\ No newline at end of file
@@ -4,98 +4,157 @@
 #include <vector>
 #include <algorithm>
 #include <chrono>
+#include <random>
+#include <thread>
+#include <filesystem>
+#include "greedy.h"
 
 using namespace std;
+using namespace greedy;
 
-struct Item {
-    int price;
-    int weight;
-    double specific_price;
-
-    Item(int _price, int _weight) noexcept :
-        price(_price),
-        weight(_weight),
-        specific_price(static_cast<double>(price) / weight) {}
-};
-
-
-int solve(int max_weight, const vector<Item>& items) noexcept {
-    vector<Item> sorted_items = items;
-    sort(sorted_items.begin(), sorted_items.end(), [](const Item& lhs, const Item& rhs) {
-        return rhs.specific_price < lhs.specific_price;
-    });
-
-    int best_price = 0;
-    int weight = 0;
-    for (int i = 0; i < items.size() && weight < max_weight; ++i) {
-        if (weight + sorted_items[i].weight <= max_weight) {
-            best_price += sorted_items[i].price;
-            weight += sorted_items[i].weight;
-        }
-    }
-    return best_price;
-}
-
-vector<Item> manual_input(int& n, int& max_weight) noexcept {
-    cout << "Input number of items: ";
-    cin >> n;
-    cout << "Input max backpack weight: ";
-    cin >> max_weight;
-    cout << "Input n pairs: price - weight\n";
-    vector<Item> items;
-    items.reserve(n);
-    for (int i = 0; i < n; ++i) {
-        int price, weight;
-        cin >> price >> weight;
-        items.emplace_back(price, weight);
-    }
-    return items;
-}
-
-vector<Item> file_input(int& n, int& max_weight, const string& filename) {
+#if defined(BENCHMARK)
+// прежняя загрузка: ifstream >> по одному числу
+vector<Item> stream_input(int& n, int& max_weight, const string& filename) {
     ifstream file(filename);
-    if (!file.is_open()) {
-        cerr << "Error: can't open the file '" << filename << "'.\n";
-        return {};
-    }
-
     file >> n >> max_weight;
     vector<Item> items;
     items.reserve(n);
     for (int i = 0; i < n; ++i) {
         int price, weight;
         file >> price >> weight;
-        items.emplace_back(price, weight);
+        items.push_back({price, weight});
     }
     return items;
 }
 
-vector<Item> input_data(int& n, int& max_weight) {
-    string filename;
-    cout << "Enter input filename or press Enter to manually input data: ";
-    getline(cin, filename);
-    if (filename.empty()) {
-        return manual_input(n, max_weight);
+// время загрузки текстового файла (ifstream, mmap в один поток и во все ядра) и двоичного; для сравнения - время solve
+// с сортировкой при подготовке и время solve_partitioned с подготовкой без сортировки
+void benchmark() {
+    string text_filename = (filesystem::temp_directory_path() / "knapsack_benchmark.txt").string();
+    string binary_filename = (filesystem::temp_directory_path() / "knapsack_benchmark.bin").string();
+    int threads_count = static_cast<int>(max(1u, thread::hardware_concurrency()));
+    cout << "Files are read from the page cache, parse threads: " << threads_count << '\n';
+    cout << "n\ttext MB\tifstream ms\tmmap text 1 thread ms\tmmap text ms\tmmap binary ms\tsolve ms\tpartitioned solve ms\tsame items\tsame answer\n";
+    for (int n : {1'000'000, 10'000'000, 50'000'000}) {
+        mt19937 generator(n);
+        uniform_int_distribution<int> distribution(1, 80); // малые значения: суммарная стоимость 50 млн предметов должна помещаться в int
+        vector<int> prices(n), weights(n);
+        {
+            ofstream file(text_filename);
+            long long total_weight = 0;
+            string buffer;
+            for (int i = 0; i < n; ++i) {
+                prices[i] = distribution(generator);
+                weights[i] = distribution(generator);
+                total_weight += weights[i];
+            }
+            int max_weight = static_cast<int>(total_weight / 2);
+            file << n << ' ' << max_weight << '\n';
+            for (int i = 0; i < n; ++i) {
+                buffer += to_string(prices[i]);
+                buffer += ' ';
+                buffer += to_string(weights[i]);
+                buffer += '\n';
+                if (1 << 20 < buffer.size()) {
+                    file << buffer;
+                    buffer.clear();
+                }
+            }
+            file << buffer;
+            save_binary_instance(binary_filename, max_weight, prices.data(), weights.data(), n);
+        }
+        double megabytes = filesystem::file_size(text_filename) / 1e6;
+
+        auto milliseconds_since = [](chrono::high_resolution_clock::time_point start) {
+            return chrono::duration<double, milli>(chrono::high_resolution_clock::now() - start).count();
+        };
+        auto same_items = [&](const int* loaded_prices, const int* loaded_weights) {
+            return equal(prices.begin(), prices.end(), loaded_prices) && equal(weights.begin(), weights.end(), loaded_weights);
+        };
+        int loaded_n, max_weight;
+        auto start = chrono::high_resolution_clock::now();
+        vector<Item> items = stream_input(loaded_n, max_weight, text_filename);
+        double stream_time = milliseconds_since(start);
+        bool same = loaded_n == n;
+        for (int i = 0; same && i < n; ++i) {
+            same = items[i].price == prices[i] && items[i].weight == weights[i];
+        }
+
+        double text_times[2];
+        for (int k = 0; k < 2; ++k) {
+            LoadedInstance instance;
+            start = chrono::high_resolution_clock::now();
+            load_instance(text_filename, instance, k == 0 ? 1 : threads_count);
+            text_times[k] = milliseconds_since(start);
+            same = same && instance.count == n && same_items(instance.prices, instance.weights);
+        }
+
+        LoadedInstance instance;
+        start = chrono::high_resolution_clock::now();
+        load_instance(binary_filename, instance);
+        long long checksum = 0; // обходим данные, иначе замер покажет только отображение без чтения страниц
+        for (int i = 0; i < instance.count; ++i) {
+            checksum += instance.prices[i] + instance.weights[i];
+        }
+        double binary_time = milliseconds_since(start);
+        same = same && instance.count == n && 0 < checksum && same_items(instance.prices, instance.weights);
+
+        start = chrono::high_resolution_clock::now(); // подготовка задачи (сортировка) входит во время решения, как и раньше
+        Instance prepared;
+        prepare_instance(max_weight, items, prepared);
+        Solution sorted_solution = solve(prepared);
+        double solve_time = milliseconds_since(start);
+
+        start = chrono::high_resolution_clock::now();
+        Instance unsorted;
+        prepare_instance(max_weight, items, unsorted, false);
+        Solution partitioned_solution = solve_partitioned(unsorted);
+        double partitioned_time = milliseconds_since(start);
+
+        cout << n << '\t' << megabytes << '\t' << stream_time << '\t' << text_times[0] << '\t' << text_times[1] << '\t' << binary_time << '\t'
+            << solve_time << '\t' << partitioned_time << '\t' << (same ? "yes" : "no") << '\t'
+            << (sorted_solution.items == partitioned_solution.items ? "yes" : "no") << '\n';
     }
-    return file_input(n, max_weight, filename);
+    filesystem::remove(text_filename);
+    filesystem::remove(binary_filename);
 }
+#endif
 
-int main() {
-    int n, max_weight;
-    vector<Item> items = input_data(n, max_weight);
+// Аргументы командной строки: --config=файл, --time_limit=мс (срок решения, по истечении выводится лучший найденный ответ)
+// и --partition=1 (без сортировки всех предметов, см. solve_partitioned)
+int main(int argc, char* argv[]) {
+#if defined(BENCHMARK)
+    benchmark();
+    return 0;
+#endif
+    GreedySolver solver;
+    BatchOptions batch;
+    StatisticsOptions statistics;
+    if (!parse_batch_arguments(argc, argv, batch) || !parse_statistics_arguments(argc, argv, statistics) || !parse_arguments({&solver}, argc, argv)) {
+        return 1;
+    }
+    Instrumentation instrumentation;
+    StatisticsReporter reporter(instrumentation, statistics); // выводит статистику, только если она запрошена
+    if (statistics.enabled) {
+        solver.instrumentation = &instrumentation;
+    }
+    if (batch.source != BatchSource::none) {
+        return run_batch(batch, solver);
+    }
+    Instance instance;
+    if (!input_data(instance, solver.needs_sorted_items())) {
+        return 1;
+    }
+    cancel_on_interrupt(solver);
     auto start = chrono::high_resolution_clock::now();
-    int best_price = solve(max_weight, items);
+    ReductionStatistics reduction;
+    Solution solution = solver.solve(instance, &reduction);
     auto end = chrono::high_resolution_clock::now();
-    auto time_spent = end - start;
-    cout << "Maximum price that can be taken: " << best_price << '\n';
-    cout << "Time spent:\n";
-    cout << "t = " << time_spent.count() << " nanoseconds\n";
-    cout << "t ~ " << chrono::duration_cast<chrono::milliseconds>(time_spent).count() << " milliseconds\n";
-    cout << "t ~ " << chrono::duration_cast<chrono::seconds>(time_spent).count() << " seconds\n";
-#if defined(NDEBUG)
-    std::cout << "Press Enter to exit...";
-    std::cin.ignore();
-    std::cin.get();
-#endif
+    reporter.stop();
+    if (solver.reduction && instance.sorted) { // без сортировки предобработки нет
+        print_reduction(reduction);
+    }
+    print_solution(solution, end - start);
+    wait_for_exit();
     return 0;
 }
\ No newline at end of file
@@ -0,0 +1,302 @@
+#pragma once
+
+#include <algorithm>
+#include <vector>
+#include "knapsack.h"
+
+#define PARTITION 0 // 1 - жадный ответ без сортировки всех предметов (solve_partitioned), для очень больших задач
+#define PARTITION_ROUNDS 16 // после стольких разбиений solve_partitioned досортировывает оставшиеся предметы: так худший случай - O(n log n)
+#define LOCAL_SEARCH_ITEMS 32 // сколько взятых и сколько невзятых предметов около критического перебирает локальный поиск
+
+namespace greedy {
+
+// оценка Данцига (линейная релаксация): предметы по убыванию удельной стоимости берутся целиком, от критического - часть
+inline long long linear_relaxation_bound(const Instance& instance) noexcept {
+    long long price = 0;
+    long long weight_left = instance.max_weight;
+    if (weight_left < 0) {
+        return 0;
+    }
+    for (int i = 0; i < instance.count; ++i) {
+        if (weight_left < instance.sorted_weights[i]) {
+            return price + weight_left * instance.sorted_prices[i] / instance.sorted_weights[i];
+        }
+        price += instance.sorted_prices[i];
+        weight_left -= instance.sorted_weights[i];
+    }
+    return price;
+}
+
+// предметы берутся по убыванию удельной стоимости, пока помещаются; порядок уже посчитан при подготовке задачи
+// ответ сопровождается оценкой Данцига, поэтому известно, насколько он может уступать оптимуму
+inline Solution solve(const Instance& instance, Instrumentation* instrumentation = nullptr, SolveControl* control = nullptr) noexcept {
+    PhaseTimer phase(instrumentation, Phase::search);
+    Solution solution;
+    long long weight = 0;
+    for (int i = 0; i < instance.count && weight < instance.max_weight; ++i) {
+        if (weight + instance.sorted_weights[i] <= instance.max_weight) {
+            solution.price += instance.sorted_prices[i];
+            solution.items.push_back(instance.order[i]);
+            weight += instance.sorted_weights[i];
+        }
+    }
+    std::sort(solution.items.begin(), solution.items.end());
+    solution.upper_bound = linear_relaxation_bound(instance);
+    if (control != nullptr) {
+        control->publish(solution);
+    }
+    return solution;
+}
+
+/*
+Начальный ответ для точных решателей (например, рекорд метода ветвей и границ), нужен порядок instance.order:
+1. Лучший из жадного ответа и ответа "самый дорогой помещающийся предмет, затем жадное заполнение" - жадный ответ
+   может быть сколь угодно плох, когда дорогой предмет не помещается после дешевых, а лучший из двух - не хуже половины оптимума.
+2. Локальный поиск среди LOCAL_SEARCH_ITEMS последних взятых и LOCAL_SEARCH_ITEMS первых невзятых предметов: добавление
+   предмета, замена 1 на 1 (1-swap), 2 на 1 и 1 на 2 (2-swap). Каждый шаг применяет лучший ход, пока стоимость растет,
+   но не больше 2 * LOCAL_SEARCH_ITEMS шагов.
+Около критического предмета удельные стоимости близки, поэтому именно там замены чаще всего находят улучшение.
+O(n + k^3) на шаг при k = LOCAL_SEARCH_ITEMS.
+*/
+inline Solution local_search_solve(const Instance& instance) noexcept {
+    const int count = instance.count;
+    const long long max_weight = instance.max_weight;
+    const int* prices = instance.sorted_prices.data();
+    const int* weights = instance.sorted_weights.data();
+    std::vector<char> taken(count, 0);
+    long long price = 0, weight = 0;
+    auto fill = [&](std::vector<char>& chosen, long long& chosen_price, long long& chosen_weight) {
+        for (int i = 0; i < count && chosen_weight < max_weight; ++i) {
+            if (!chosen[i] && chosen_weight + weights[i] <= max_weight) {
+                chosen[i] = 1;
+                chosen_price += prices[i];
+                chosen_weight += weights[i];
+            }
+        }
+    };
+    fill(taken, price, weight);
+
+    int best_item = -1;
+    for (int i = 0; i < count; ++i) {
+        if (weights[i] <= max_weight && (best_item < 0 || prices[best_item] < prices[i])) {
+            best_item = i;
+        }
+    }
+    if (0 <= best_item && !taken[best_item]) {
+        std::vector<char> alternative(count, 0);
+        alternative[best_item] = 1;
+        long long alternative_price = prices[best_item], alternative_weight = weights[best_item];
+        fill(alternative, alternative_price, alternative_weight);
+        if (price < alternative_price) {
+            taken.swap(alternative);
+            price = alternative_price;
+            weight = alternative_weight;
+        }
+    }
+
+    std::vector<int> window; // позиции, которые перебирает локальный поиск
+    for (int i = count - 1, found = 0; 0 <= i && found < LOCAL_SEARCH_ITEMS; --i) {
+        if (taken[i]) {
+            window.push_back(i);
+            ++found;
+        }
+    }
+    for (int i = 0, found = 0; i < count && found < LOCAL_SEARCH_ITEMS; ++i) {
+        if (!taken[i] && weights[i] <= max_weight) {
+            window.push_back(i);
+            ++found;
+        }
+    }
+    const int size = static_cast<int>(window.size());
+    for (int step = 0; step < size; ++step) {
+        long long best_gain = 0;
+        int move[3] = {-1, -1, -1}; // позиции в window, чье значение меняется
+        auto consider = [&](long long gain, long long weight_change, int a, int b, int c) {
+            if (best_gain < gain && weight + weight_change <= max_weight) {
+                best_gain = gain;
+                move[0] = a;
+                move[1] = b;
+                move[2] = c;
+            }
+        };
+        for (int a = 0; a < size; ++a) {
+            int i = window[a];
+            long long sign_i = taken[i] ? -1 : 1;
+            if (!taken[i]) {
+                consider(prices[i], weights[i], a, -1, -1); // добавление
+            }
+            for (int b = a + 1; b < size; ++b) {
+                int j = window[b];
+                if (taken[i] == taken[j]) {
+                    for (int c = 0; c < size; ++c) { // 2 на 1 или 1 на 2: третий предмет с другим значением
+                        int k = window[c];
+                        if (taken[k] != taken[i]) {
+                            consider(sign_i * (prices[i] + prices[j]) - sign_i * prices[k], sign_i * (weights[i] + weights[j]) - sign_i * weights[k], a, b, c);
+                        }
+                    }
+                } else {
+                    consider(sign_i * (prices[i] - prices[j]), sign_i * (weights[i] - weights[j]), a, b, -1); // 1 на 1
+                }
+            }
+        }
+        if (best_gain == 0) {
+            break;
+        }
+        for (int a : move) {
+            if (0 <= a) {
+                int i = window[a];
+                taken[i] = !taken[i];
+                price += taken[i] ? prices[i] : -prices[i];
+                weight += taken[i] ? weights[i] : -weights[i];
+            }
+        }
+    }
+
+    Solution solution;
+    solution.price = price;
+    for (int i = 0; i < count; ++i) {
+        if (taken[i]) {
+            solution.items.push_back(instance.order[i]);
+        }
+    }
+    std::sort(solution.items.begin(), solution.items.end());
+    solution.upper_bound = linear_relaxation_bound(instance);
+    return solution;
+}
+
+/*
+Позиция критического предмета среди candidates[first, last) в порядке precedes (разбиение с опорным элементом, как в
+поиске k-го элемента по Балашу - Земелу): после вызова лучшие предметы лежат в [first, critical), их суммарный вес
+weight не больше capacity, а с предметом candidates[critical] он был бы больше. Порядок внутри частей не задается,
+поэтому в среднем это O(last - first) вместо сортировки. critical = last, если помещаются все.
+*/
+inline int find_critical(const Instance& instance, std::vector<int>& candidates, int first, int last, long long capacity, long long& weight) noexcept {
+    auto better = [&](int lhs, int rhs) { return precedes(instance, lhs, rhs); };
+    weight = 0;
+    int low = first, high = last; // критический в [low, high], все до low уже помещаются
+    while (low < high) {
+        int middle = low + (high - low) / 2; // опорный - медиана трех, так худший случай на упорядоченных данных не наступает
+        if (better(candidates[middle], candidates[low])) {
+            std::swap(candidates[middle], candidates[low]);
+        }
+        if (better(candidates[high - 1], candidates[low])) {
+            std::swap(candidates[high - 1], candidates[low]);
+        }
+        if (better(candidates[high - 1], candidates[middle])) {
+            std::swap(candidates[high - 1], candidates[middle]);
+        }
+        int pivot = candidates[middle];
+        int split = static_cast<int>(std::partition(candidates.begin() + low, candidates.begin() + high,
+            [&](int item) { return better(item, pivot); }) - candidates.begin());
+        long long better_weight = 0;
+        for (int i = low; i < split; ++i) {
+            better_weight += instance.weights[candidates[i]];
+        }
+        if (capacity < weight + better_weight) {
+            high = split; // критический среди лучших опорного
+            continue;
+        }
+        weight += better_weight;
+        std::swap(*std::find(candidates.begin() + split, candidates.begin() + high, pivot), candidates[split]); // опорный - сразу за лучшими
+        if (capacity < weight + instance.weights[pivot]) {
+            return split;
+        }
+        weight += instance.weights[pivot];
+        low = split + 1;
+    }
+    return low;
+}
+
+/*
+Тот же ответ, что у solve, но без порядка instance.order: задача может быть подготовлена без сортировки (prepare_instance
+с sort = false), а вместо перестановки предметов используется перестановка индексов. Лучшие предметы до критического
+берутся все, критический не помещается, дальше то же повторяется для оставшихся предметов на оставшуюся вместимость -
+уже только для тех, что в нее помещаются. Оценка Данцига считается по первому критическому среди помещающихся
+предметов, поэтому она не больше, чем у solve.
+Раунд может убрать всего пару предметов, поэтому раундов не больше PARTITION_ROUNDS: оставшиеся предметы сортируются
+и берутся по порядку, если помещаются, - тот же ответ, что дали бы следующие раунды.
+*/
+inline Solution solve_partitioned(const Instance& instance, Instrumentation* instrumentation = nullptr, SolveControl* control = nullptr) noexcept {
+    PhaseTimer phase(instrumentation, Phase::search);
+    Solution solution;
+    long long capacity = instance.max_weight;
+    std::vector<int> candidates;
+    candidates.reserve(instance.count);
+    for (int i = 0; i < instance.count; ++i) {
+        if (instance.weights[i] <= capacity) {
+            candidates.push_back(i);
+        }
+    }
+    std::vector<char> taken(instance.count, 0);
+    long long price = 0;
+    int first = 0, last = static_cast<int>(candidates.size());
+    for (int round = 0; first < last && 0 < capacity && round < PARTITION_ROUNDS; ++round) {
+        long long weight;
+        int critical = find_critical(instance, candidates, first, last, capacity, weight);
+        for (int i = first; i < critical; ++i) {
+            taken[candidates[i]] = 1;
+            price += instance.prices[candidates[i]];
+        }
+        capacity -= weight;
+        if (solution.upper_bound < 0) {
+            solution.upper_bound = price + (critical < last ? capacity * instance.prices[candidates[critical]] / instance.weights[candidates[critical]] : 0);
+        }
+        first = critical + 1;
+        last = static_cast<int>(std::remove_if(candidates.begin() + first, candidates.begin() + last,
+            [&](int item) { return capacity < instance.weights[item]; }) - candidates.begin());
+    }
+    if (first < last && 0 < capacity) {
+        std::sort(candidates.begin() + first, candidates.begin() + last, [&](int lhs, int rhs) { return precedes(instance, lhs, rhs); });
+        for (int i = first; i < last; ++i) {
+            int item = candidates[i];
+            if (instance.weights[item] <= capacity) {
+                taken[item] = 1;
+                price += instance.prices[item];
+                capacity -= instance.weights[item];
+            }
+        }
+    }
+    solution.price = price;
+    for (int i = 0; i < instance.count; ++i) {
+        if (taken[i]) {
+            solution.items.push_back(i);
+        }
+    }
+    if (solution.upper_bound < 0) {
+        solution.upper_bound = std::max(0ll, price); // ни одного предмета не помещается
+    }
+    if (control != nullptr) {
+        control->publish(solution);
+    }
+    return solution;
+}
+
+class GreedySolver : public Solver {
+public:
+    bool partition = PARTITION; // параметр partition (0 или 1), см. solve_partitioned
+
+    const char* name() const noexcept override {
+        return "greedy";
+    }
+
+    bool needs_sorted_items() const noexcept override {
+        return !partition;
+    }
+
+protected:
+    Solution solve_instance(const Instance& instance, SolveControl& control) const override {
+        return partition ? solve_partitioned(instance, instrumentation, &control) : greedy::solve(instance, instrumentation, &control);
+    }
+
+    ParameterStatus set_solver_parameter(const std::string& name, const std::string& value) override {
+        if (name != "partition") {
+            return ParameterStatus::unknown;
+        }
+        int enabled;
+        bool parsed = parse_number(value, enabled) && (enabled == 0 || enabled == 1);
+        partition = parsed ? enabled == 1 : partition;
+        return parsed ? ParameterStatus::applied : ParameterStatus::invalid;
+    }
+};
+
+}
\ No newline at end of file
@@ -0,0 +1,32 @@
+#include <iostream>
+#include <string>
+#include <chrono>
+#include "instance_loader.h"
+
+using namespace std;
+
+// Переводит входные данные из текстового формата в двоичный (см. instance_loader.h), который загружается без разбора.
+// Аргументы командной строки: входной и выходной файлы; если их нет, имена запрашиваются.
+int main(int argc, char* argv[]) {
+    string input_filename, output_filename;
+    if (argc == 3) {
+        input_filename = argv[1];
+        output_filename = argv[2];
+    } else {
+        cout << "Enter input filename: ";
+        getline(cin, input_filename);
+        cout << "Enter output filename: ";
+        getline(cin, output_filename);
+    }
+
+    auto start = chrono::high_resolution_clock::now();
+    LoadedInstance instance;
+    if (!load_instance(input_filename, instance) ||
+        !save_binary_instance(output_filename, instance.max_weight, instance.prices, instance.weights, instance.count)) {
+        return 1;
+    }
+    auto time_spent = chrono::high_resolution_clock::now() - start;
+    cout << "Items converted: " << instance.count << '\n';
+    cout << "t ~ " << chrono::duration_cast<chrono::milliseconds>(time_spent).count() << " milliseconds\n";
+    return 0;
+}
\ No newline at end of file
@@ -0,0 +1,142 @@
+#pragma once
+
+/*
+Генераторы классических семейств задач (Pisinger, "Where are the hard knapsack problems?").
+Веса и стоимости - в диапазоне [1, range], r = range / 10:
+    uncorrelated - вес и стоимость независимы;
+    weakly_correlated - стоимость в [вес - r, вес + r] (не меньше 1);
+    strongly_correlated - стоимость = вес + r;
+    inverse_strongly_correlated - вес = стоимость + r;
+    subset_sum - стоимость = вес;
+    spanner - spanner(2, 10): 2 сильно коррелированных предмета-образца, уменьшенных в 11 раз, каждый предмет -
+    случайный образец, умноженный на случайный множитель от 1 до 10.
+Вместимость - доля capacity_ratio от суммарного веса. Генератор свой (splitmix64), а не распределения стандартной
+библиотеки, поэтому задача зависит только от зерна, а не от компилятора.
+Суммарная стоимость должна помещаться в int, т. е. n * range должно быть меньше 2^31.
+*/
+
+#include <string>
+#include <vector>
+#include <algorithm>
+#include <climits>
+#include <cstdint>
+#include "knapsack.h"
+
+enum class InstanceFamily {
+    uncorrelated,
+    weakly_correlated,
+    strongly_correlated,
+    inverse_strongly_correlated,
+    subset_sum,
+    spanner
+};
+
+constexpr InstanceFamily INSTANCE_FAMILIES[] = {
+    InstanceFamily::uncorrelated,
+    InstanceFamily::weakly_correlated,
+    InstanceFamily::strongly_correlated,
+    InstanceFamily::inverse_strongly_correlated,
+    InstanceFamily::subset_sum,
+    InstanceFamily::spanner
+};
+
+inline const char* family_name(InstanceFamily family) noexcept {
+    switch (family) {
+    case InstanceFamily::uncorrelated:
+        return "uncorrelated";
+    case InstanceFamily::weakly_correlated:
+        return "weakly_correlated";
+    case InstanceFamily::strongly_correlated:
+        return "strongly_correlated";
+    case InstanceFamily::inverse_strongly_correlated:
+        return "inverse_strongly_correlated";
+    case InstanceFamily::subset_sum:
+        return "subset_sum";
+    case InstanceFamily::spanner:
+        return "spanner";
+    }
+    return "";
+}
+
+inline bool parse_family(const std::string& name, InstanceFamily& family) noexcept {
+    for (InstanceFamily candidate : INSTANCE_FAMILIES) {
+        if (name == family_name(candidate)) {
+            family = candidate;
+            return true;
+        }
+    }
+    return false;
+}
+
+class InstanceGenerator {
+public:
+    explicit InstanceGenerator(uint64_t seed) noexcept :
+        state_(seed) {}
+
+    // равномерно в [low, high]; смещение от взятия остатка при диапазонах до 2^31 пренебрежимо мало
+    int uniform(int low, int high) noexcept {
+        return low + static_cast<int>(next() % static_cast<uint64_t>(high - low + 1));
+    }
+
+private:
+    uint64_t state_;
+
+    uint64_t next() noexcept {
+        uint64_t z = (state_ += 0x9e3779b97f4a7c15ull);
+        z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ull;
+        z = (z ^ (z >> 27)) * 0x94d049bb133111ebull;
+        return z ^ (z >> 31);
+    }
+};
+
+// заполняет и готовит instance; одинаковые аргументы дают одинаковую задачу
+inline void generate_instance(InstanceFamily family, int n, int range, double capacity_ratio, uint64_t seed, Instance& instance) {
+    constexpr int spanner_size = 2;
+    constexpr int spanner_multiplier = 10;
+    InstanceGenerator generator(seed);
+    int correlation = std::max(1, range / 10);
+    std::vector<int> prices(n), weights(n);
+    std::vector<int> span_prices(spanner_size), span_weights(spanner_size);
+    if (family == InstanceFamily::spanner) {
+        for (int k = 0; k < spanner_size; ++k) {
+            int weight = generator.uniform(1, range);
+            span_weights[k] = (weight + spanner_multiplier) / (spanner_multiplier + 1);
+            span_prices[k] = (weight + correlation + spanner_multiplier) / (spanner_multiplier + 1);
+        }
+    }
+    long long total_weight = 0;
+    for (int i = 0; i < n; ++i) {
+        switch (family) {
+        case InstanceFamily::uncorrelated:
+            weights[i] = generator.uniform(1, range);
+            prices[i] = generator.uniform(1, range);
+            break;
+        case InstanceFamily::weakly_correlated:
+            weights[i] = generator.uniform(1, range);
+            prices[i] = generator.uniform(std::max(1, weights[i] - correlation), weights[i] + correlation);
+            break;
+        case InstanceFamily::strongly_correlated:
+            weights[i] = generator.uniform(1, range);
+            prices[i] = weights[i] + correlation;
+            break;
+        case InstanceFamily::inverse_strongly_correlated:
+            prices[i] = generator.uniform(1, range);
+            weights[i] = prices[i] + correlation;
+            break;
+        case InstanceFamily::subset_sum:
+            weights[i] = generator.uniform(1, range);
+            prices[i] = weights[i];
+            break;
+        case InstanceFamily::spanner: {
+            int k = generator.uniform(0, spanner_size - 1);
+            int multiplier = generator.uniform(1, spanner_multiplier);
+            weights[i] = span_weights[k] * multiplier;
+            prices[i] = span_prices[k] * multiplier;
+            break;
+        }
+        }
+        total_weight += weights[i];
+    }
+    long long max_weight = static_cast<long long>(capacity_ratio * static_cast<double>(total_weight));
+    prepare_instance(static_cast<int>(std::clamp(max_weight, 1ll, static_cast<long long>(INT_MAX))), prices.data(), weights.data(), n, instance);
+}
\ No newline at end of file
@@ -0,0 +1,344 @@
+#pragma once
+
+/*
+Общий загрузчик входных данных для всех решателей.
+
+Текстовый формат (как и раньше): число предметов n, максимальный вес рюкзака, затем n пар "стоимость вес".
+Файл отображается в память (mmap), числа разбираются через from_chars без потоков ввода;
+большие файлы разбираются несколькими потоками по кускам.
+
+Двоичный формат: заголовок BinaryInstanceHeader, затем n стоимостей и n весов (int32, порядок байт машины).
+Такой файл не разбирается вовсе - массивы стоимостей и весов указывают прямо в отображенную память.
+Формат определяется по сигнатуре в начале файла.
+*/
+
+#include <iostream>
+#include <fstream>
+#include <string>
+#include <vector>
+#include <thread>
+#include <algorithm>
+#include <charconv>
+#include <cstdint>
+#include <cstring>
+#if defined(_WIN32)
+#if !defined(NOMINMAX)
+#define NOMINMAX
+#endif
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+constexpr char BINARY_INSTANCE_MAGIC[8] = {'K', 'N', 'A', 'P', 'S', 'O', 'A', '\0'};
+constexpr uint32_t BINARY_INSTANCE_VERSION = 1;
+constexpr size_t PARALLEL_PARSE_MIN_BYTES = 1 << 22; // файлы меньше разбираются одним потоком - запуск потоков дороже разбора
+
+struct BinaryInstanceHeader {
+    char magic[8]; // BINARY_INSTANCE_MAGIC
+    uint32_t version; // BINARY_INSTANCE_VERSION
+    int32_t max_weight;
+    int64_t count; // число предметов; за заголовком int32 prices[count], затем int32 weights[count]
+};
+static_assert(sizeof(BinaryInstanceHeader) == 24, "binary instance header must have no padding");
+
+// файл, отображенный в память только для чтения; освобождается в деструкторе
+class MappedFile {
+public:
+    MappedFile() noexcept = default;
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    MappedFile(MappedFile&& other) noexcept :
+        data_(other.data_),
+        size_(other.size_) {
+        other.data_ = nullptr;
+        other.size_ = 0;
+    }
+
+    MappedFile& operator=(MappedFile&& other) noexcept {
+        if (this != &other) {
+            unmap();
+            data_ = other.data_;
+            size_ = other.size_;
+            other.data_ = nullptr;
+            other.size_ = 0;
+        }
+        return *this;
+    }
+
+    ~MappedFile() noexcept {
+        unmap();
+    }
+
+    // false, если файл не открылся; пустой файл отображается как пустой диапазон
+    bool open(const std::string& filename) noexcept {
+        unmap();
+#if defined(_WIN32)
+        HANDLE file = CreateFileA(filename.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+        if (file == INVALID_HANDLE_VALUE) {
+            return false;
+        }
+        LARGE_INTEGER file_size;
+        bool opened = GetFileSizeEx(file, &file_size);
+        if (opened && 0 < file_size.QuadPart) {
+            HANDLE mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+            void* view = mapping != nullptr ? MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0) : nullptr;
+            if (mapping != nullptr) {
+                CloseHandle(mapping); // отображение держится открытым видом
+            }
+            opened = view != nullptr;
+            if (opened) {
+                data_ = static_cast<const char*>(view);
+                size_ = static_cast<size_t>(file_size.QuadPart);
+            }
+        }
+        CloseHandle(file);
+        return opened;
+#else
+        int file = ::open(filename.c_str(), O_RDONLY);
+        if (file < 0) {
+            return false;
+        }
+        struct stat file_stat;
+        bool opened = fstat(file, &file_stat) == 0;
+        if (opened && 0 < file_stat.st_size) {
+            void* view = mmap(nullptr, static_cast<size_t>(file_stat.st_size), PROT_READ, MAP_PRIVATE, file, 0);
+            opened = view != MAP_FAILED;
+            if (opened) {
+                madvise(view, static_cast<size_t>(file_stat.st_size), MADV_SEQUENTIAL);
+                data_ = static_cast<const char*>(view);
+                size_ = static_cast<size_t>(file_stat.st_size);
+            }
+        }
+        close(file); // отображение остается действительным и после закрытия файла
+        return opened;
+#endif
+    }
+
+    const char* data() const noexcept {
+        return data_;
+    }
+
+    size_t size() const noexcept {
+        return size_;
+    }
+
+private:
+    void unmap() noexcept {
+        if (data_ != nullptr) {
+#if defined(_WIN32)
+            UnmapViewOfFile(data_);
+#else
+            munmap(const_cast<char*>(data_), size_);
+#endif
+        }
+        data_ = nullptr;
+        size_ = 0;
+    }
+
+    const char* data_ = nullptr;
+    size_t size_ = 0;
+};
+
+/*
+Загруженные данные в виде структуры массивов. Для двоичного файла prices и weights указывают в mapping (без копирования),
+для текстового - в price_storage и weight_storage.
+*/
+struct LoadedInstance {
+    int max_weight = 0;
+    int count = 0; // число предметов
+    const int* prices = nullptr;
+    const int* weights = nullptr;
+    MappedFile mapping;
+    std::vector<int> price_storage;
+    std::vector<int> weight_storage;
+};
+
+inline bool is_blank(char symbol) noexcept {
+    return symbol == ' ' || symbol == '\n' || symbol == '\r' || symbol == '\t' || symbol == '\v' || symbol == '\f';
+}
+
+// следующее целое из [position, end); position сдвигается за число
+inline bool parse_int(const char*& position, const char* end, int& value) noexcept {
+    while (position < end && is_blank(*position)) {
+        ++position;
+    }
+    auto [next, error] = std::from_chars(position, end, value);
+    if (error != std::errc() || (next < end && !is_blank(*next))) {
+        return false;
+    }
+    position = next;
+    return true;
+}
+
+// число слов (последовательностей непробельных символов) в [first, last)
+inline long long count_tokens(const char* first, const char* last) noexcept {
+    long long tokens = 0;
+    bool in_token = false;
+    for (const char* position = first; position < last; ++position) {
+        bool blank = is_blank(*position);
+        tokens += !blank && !in_token;
+        in_token = !blank;
+    }
+    return tokens;
+}
+
+/*
+Числа из [first, last) по порядку, начиная с числа номер first_token: четные - стоимости, нечетные - веса.
+Возвращает номер следующего числа или -1, если встретилось не число или чисел больше tokens_count.
+*/
+inline long long parse_tokens(const char* first, const char* last, long long first_token, long long tokens_count, int* prices, int* weights) noexcept {
+    long long token = first_token;
+    const char* position = first;
+    while (true) {
+        while (position < last && is_blank(*position)) {
+            ++position;
+        }
+        if (position == last) {
+            return token;
+        }
+        int value;
+        if (token == tokens_count || !parse_int(position, last, value)) {
+            return -1;
+        }
+        if (token % 2 == 0) {
+            prices[token / 2] = value;
+        } else {
+            weights[token / 2] = value;
+        }
+        ++token;
+    }
+}
+
+/*
+Разбор текста по кускам: границы кусков сдвигаются вперед до пробельного символа, чтобы не разрезать число.
+Первый проход считает числа в каждом куске, по префиксным суммам каждый поток узнает, с какого числа начинается его кусок,
+второй проход разбирает числа сразу на свои места.
+*/
+inline bool parse_text_items(const char* first, const char* last, int count, int* prices, int* weights, int threads_count) {
+    size_t size = static_cast<size_t>(last - first);
+    if (threads_count <= 0) {
+        threads_count = size < PARALLEL_PARSE_MIN_BYTES ? 1 : static_cast<int>(std::max(1u, std::thread::hardware_concurrency()));
+    }
+    threads_count = static_cast<int>(std::min<size_t>(threads_count, std::max<size_t>(1, size / 4096)));
+    if (threads_count == 1) {
+        return parse_tokens(first, last, 0, 2ll * count, prices, weights) == 2ll * count;
+    }
+
+    std::vector<const char*> bounds(threads_count + 1);
+    bounds[0] = first;
+    bounds[threads_count] = last;
+    for (int t = 1; t < threads_count; ++t) {
+        const char* bound = std::max(bounds[t - 1], first + size / threads_count * t);
+        while (bound < last && !is_blank(bound[-1])) {
+            ++bound;
+        }
+        bounds[t] = bound;
+    }
+
+    std::vector<long long> first_tokens(threads_count + 1, 0);
+    std::vector<char> parsed(threads_count, 1);
+    std::vector<std::thread> threads;
+    threads.reserve(threads_count);
+    for (int t = 0; t < threads_count; ++t) {
+        threads.emplace_back([&, t]() {
+            first_tokens[t + 1] = count_tokens(bounds[t], bounds[t + 1]);
+        });
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+    for (int t = 0; t < threads_count; ++t) {
+        first_tokens[t + 1] += first_tokens[t];
+    }
+    if (first_tokens[threads_count] != 2ll * count) {
+        return false;
+    }
+
+    threads.clear();
+    for (int t = 0; t < threads_count; ++t) {
+        threads.emplace_back([&, t]() {
+            parsed[t] = parse_tokens(bounds[t], bounds[t + 1], first_tokens[t], 2ll * count, prices, weights) == first_tokens[t + 1];
+        });
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+    for (char ok : parsed) {
+        if (!ok) {
+            return false;
+        }
+    }
+    return true;
+}
+
+/*
+Загружает файл в instance, формат (текстовый или двоичный) определяется по сигнатуре.
+threads_count - число потоков разбора текста, 0 - по размеру файла и числу ядер.
+При ошибке выводит сообщение и возвращает false.
+*/
+inline bool load_instance(const std::string& filename, LoadedInstance& instance, int threads_count = 0) {
+    if (!instance.mapping.open(filename)) {
+        std::cerr << "Error: can't open the file '" << filename << "'.\n";
+        return false;
+    }
+    const char* data = instance.mapping.data();
+    size_t size = instance.mapping.size();
+
+    if (sizeof(BinaryInstanceHeader) <= size && std::memcmp(data, BINARY_INSTANCE_MAGIC, sizeof(BINARY_INSTANCE_MAGIC)) == 0) {
+        BinaryInstanceHeader header;
+        std::memcpy(&header, data, sizeof(header));
+        if (header.version != BINARY_INSTANCE_VERSION || header.count < 0 || INT32_MAX < header.count ||
+            size != sizeof(header) + 2 * sizeof(int32_t) * static_cast<size_t>(header.count)) {
+            std::cerr << "Error: the binary file '" << filename << "' is damaged or has an unsupported version.\n";
+            return false;
+        }
+        instance.max_weight = header.max_weight;
+        instance.count = static_cast<int>(header.count);
+        instance.prices = reinterpret_cast<const int*>(data + sizeof(header)); // заголовок 24 байта - массивы выровнены по 8 байт
+        instance.weights = instance.prices + header.count;
+        return true;
+    }
+
+    const char* position = data;
+    const char* end = data + size;
+    int count;
+    bool parsed = parse_int(position, end, count) && 0 <= count && parse_int(position, end, instance.max_weight);
+    if (parsed) {
+        instance.count = count;
+        instance.price_storage.resize(count);
+        instance.weight_storage.resize(count);
+        parsed = parse_text_items(position, end, count, instance.price_storage.data(), instance.weight_storage.data(), threads_count);
+    }
+    instance.mapping = MappedFile(); // текст больше не нужен
+    if (!parsed) {
+        std::cerr << "Error: the file '" << filename << "' is malformed: expected n, max weight and n pairs of integers.\n";
+        return false;
+    }
+    instance.prices = instance.price_storage.data();
+    instance.weights = instance.weight_storage.data();
+    return true;
+}
+
+// записывает данные в двоичном формате
+inline bool save_binary_instance(const std::string& filename, int max_weight, const int* prices, const int* weights, int count) {
+    std::ofstream file(filename, std::ios::binary);
+    if (!file.is_open()) {
+        std::cerr << "Error: can't create the file '" << filename << "'.\n";
+        return false;
+    }
+    BinaryInstanceHeader header;
+    std::memcpy(header.magic, BINARY_INSTANCE_MAGIC, sizeof(header.magic));
+    header.version = BINARY_INSTANCE_VERSION;
+    header.max_weight = max_weight;
+    header.count = count;
+    file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    file.write(reinterpret_cast<const char*>(prices), sizeof(int32_t) * static_cast<size_t>(count));
+    file.write(reinterpret_cast<const char*>(weights), sizeof(int32_t) * static_cast<size_t>(count));
+    return static_cast<bool>(file);
+}
\ No newline at end of file
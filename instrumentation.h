@@ -0,0 +1,461 @@
+#pragma once
+
+/*
+Счетчики горячих путей решателей и периодический вывод статистики во время решения.
+
+При INSTRUMENTATION = 0 методы счетчиков пустые и вызовы удаляются компилятором. При INSTRUMENTATION = 1 решатель
+пишет счетчики, если ему передан Instrumentation (поле Solver::instrumentation), иначе каждый вызов - одна проверка указателя.
+Счетчики у каждого потока свои (ThreadCounters в своей кеш-линии). Их пишет только поток-владелец обычными
+load/store без блокировок и атомарных read-modify-write, поэтому потоки не мешают друг другу. Сумма по потокам
+считается лениво - только при снимке (snapshot), который берет поток вывода StatisticsReporter.
+Редкие события (улучшение рекорда, распределение приспособленности после поколения) копятся под блокировкой
+и забираются при каждом выводе.
+*/
+
+#include <iostream>
+#include <fstream>
+#include <string>
+#include <vector>
+#include <deque>
+#include <atomic>
+#include <mutex>
+#include <condition_variable>
+#include <thread>
+#include <algorithm>
+#include <chrono>
+#include <charconv>
+
+#if !defined(INSTRUMENTATION)
+#define INSTRUMENTATION 0 // 1 - собирать счетчики решателей (см. --stats, --stats_interval, --stats_file), 0 - счетчики удаляются при компиляции
+#endif
+
+enum class Phase {
+    preparation, // подготовка задачи (сортировка)
+    initialization, // начальное состояние решателя: оценки, начальная популяция
+    search, // основной цикл
+    reconstruction // сбор ответа
+};
+constexpr int PHASES_COUNT = 4;
+
+inline const char* phase_name(Phase phase) noexcept {
+    constexpr const char* names[PHASES_COUNT] = {"preparation", "initialization", "search", "reconstruction"};
+    return names[static_cast<int>(phase)];
+}
+
+// счетчики одного потока
+struct alignas(64) ThreadCounters {
+    std::atomic<long long> expanded_nodes{0}; // раскрытые состояния метода ветвей и границ
+    std::atomic<long long> pruned_nodes{0}; // отсеченные по оценке состояния
+    std::atomic<long long> queue_peak{0}; // наибольший размер очереди (при сложении потоков берется максимум)
+    std::atomic<long long> generations{0}; // поколения генетических алгоритмов
+    std::atomic<long long> evaluations{0}; // оцененные особи
+};
+
+struct IncumbentEvent {
+    double seconds; // время от создания Instrumentation
+    long long price;
+};
+
+// распределение приспособленности популяции (острова) после поколения
+struct FitnessSummary {
+    int island; // 0 без модели островов
+    long long generation;
+    long long min;
+    long long median;
+    double mean;
+    long long max;
+};
+
+struct StatisticsSnapshot {
+    double seconds = 0; // время от создания Instrumentation
+    long long expanded_nodes = 0;
+    long long pruned_nodes = 0;
+    long long queue_peak = 0;
+    long long generations = 0;
+    long long evaluations = 0;
+    long long incumbent_updates = 0;
+    long long best_price = -1; // -1 - рекордов еще не было
+    double phase_seconds[PHASES_COUNT] = {};
+    std::vector<IncumbentEvent> incumbents; // события с прошлого снимка
+    std::vector<FitnessSummary> fitness; // события с прошлого снимка
+};
+
+class Instrumentation {
+public:
+    Instrumentation() noexcept :
+        start_(std::chrono::steady_clock::now()) {}
+
+    Instrumentation(const Instrumentation&) = delete;
+    Instrumentation& operator=(const Instrumentation&) = delete;
+
+    // счетчики для нового потока решения; освобожденные счетчики переиспользуются, поэтому в пакетном режиме их число не растет
+    ThreadCounters* acquire_counters() {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (!free_counters_.empty()) {
+            ThreadCounters* counters = free_counters_.back();
+            free_counters_.pop_back();
+            return counters;
+        }
+        return &counters_.emplace_back();
+    }
+
+    // поток закончил решение: его счетчики переносятся в общую сумму и обнуляются
+    void release_counters(ThreadCounters* counters) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        retired_.expanded_nodes += exchange(counters->expanded_nodes);
+        retired_.pruned_nodes += exchange(counters->pruned_nodes);
+        retired_.queue_peak = std::max(retired_.queue_peak, exchange(counters->queue_peak));
+        retired_.generations += exchange(counters->generations);
+        retired_.evaluations += exchange(counters->evaluations);
+        free_counters_.push_back(counters);
+    }
+
+    void incumbent(long long price) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        ++incumbent_updates_;
+        best_price_ = std::max(best_price_, price);
+        incumbents_.push_back({elapsed_seconds(), price});
+    }
+
+    void fitness(const FitnessSummary& summary) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        fitness_.push_back(summary);
+    }
+
+    void add_phase_time(Phase phase, std::chrono::nanoseconds time) noexcept {
+        phase_nanoseconds_[static_cast<int>(phase)].fetch_add(time.count(), std::memory_order_relaxed);
+    }
+
+    // сумма счетчиков всех потоков; события забираются, поэтому каждое попадает ровно в один снимок
+    StatisticsSnapshot snapshot() {
+        StatisticsSnapshot snapshot;
+        std::lock_guard<std::mutex> lock(mutex_);
+        snapshot.seconds = elapsed_seconds();
+        snapshot.expanded_nodes = retired_.expanded_nodes;
+        snapshot.pruned_nodes = retired_.pruned_nodes;
+        snapshot.queue_peak = retired_.queue_peak;
+        snapshot.generations = retired_.generations;
+        snapshot.evaluations = retired_.evaluations;
+        for (const ThreadCounters& counters : counters_) {
+            snapshot.expanded_nodes += counters.expanded_nodes.load(std::memory_order_relaxed);
+            snapshot.pruned_nodes += counters.pruned_nodes.load(std::memory_order_relaxed);
+            snapshot.queue_peak = std::max(snapshot.queue_peak, counters.queue_peak.load(std::memory_order_relaxed));
+            snapshot.generations += counters.generations.load(std::memory_order_relaxed);
+            snapshot.evaluations += counters.evaluations.load(std::memory_order_relaxed);
+        }
+        snapshot.incumbent_updates = incumbent_updates_;
+        snapshot.best_price = best_price_;
+        for (int i = 0; i < PHASES_COUNT; ++i) {
+            snapshot.phase_seconds[i] = phase_nanoseconds_[i].load(std::memory_order_relaxed) / 1e9;
+        }
+        snapshot.incumbents.swap(incumbents_);
+        snapshot.fitness.swap(fitness_);
+        return snapshot;
+    }
+
+private:
+    struct Totals {
+        long long expanded_nodes = 0;
+        long long pruned_nodes = 0;
+        long long queue_peak = 0;
+        long long generations = 0;
+        long long evaluations = 0;
+    };
+
+    std::chrono::steady_clock::time_point start_;
+    std::mutex mutex_; // защищает все поля ниже, кроме phase_nanoseconds_
+    std::deque<ThreadCounters> counters_; // deque не перемещает элементы при росте
+    std::vector<ThreadCounters*> free_counters_;
+    Totals retired_; // сумма счетчиков закончивших потоков
+    long long incumbent_updates_ = 0;
+    long long best_price_ = -1;
+    std::vector<IncumbentEvent> incumbents_;
+    std::vector<FitnessSummary> fitness_;
+    std::atomic<long long> phase_nanoseconds_[PHASES_COUNT] = {};
+
+    static long long exchange(std::atomic<long long>& counter) noexcept {
+        return counter.exchange(0, std::memory_order_relaxed);
+    }
+
+    double elapsed_seconds() const noexcept {
+        return std::chrono::duration<double>(std::chrono::steady_clock::now() - start_).count();
+    }
+};
+
+/*
+Счетчики потока решения: берутся у Instrumentation при создании и возвращаются при уничтожении.
+Без Instrumentation (nullptr) или при INSTRUMENTATION = 0 все методы ничего не делают.
+*/
+class ThreadProbe {
+public:
+    explicit ThreadProbe(Instrumentation* instrumentation) :
+        instrumentation_(INSTRUMENTATION != 0 ? instrumentation : nullptr),
+        counters_(instrumentation_ != nullptr ? instrumentation_->acquire_counters() : nullptr) {}
+
+    ThreadProbe(const ThreadProbe&) = delete;
+    ThreadProbe& operator=(const ThreadProbe&) = delete;
+
+    ~ThreadProbe() {
+        if (enabled()) {
+            instrumentation_->release_counters(counters_);
+        }
+    }
+
+    bool enabled() const noexcept {
+        return INSTRUMENTATION != 0 && counters_ != nullptr;
+    }
+
+    void expanded() noexcept {
+        if (enabled()) {
+            add(counters_->expanded_nodes, 1);
+        }
+    }
+
+    void pruned() noexcept {
+        if (enabled()) {
+            add(counters_->pruned_nodes, 1);
+        }
+    }
+
+    void queue_size(size_t size) noexcept {
+        if (enabled() && counters_->queue_peak.load(std::memory_order_relaxed) < static_cast<long long>(size)) {
+            counters_->queue_peak.store(static_cast<long long>(size), std::memory_order_relaxed);
+        }
+    }
+
+    void incumbent(long long price) {
+        if (enabled()) {
+            instrumentation_->incumbent(price);
+        }
+    }
+
+    // поколение закончено: счетчики, распределение приспособленности и рекорд, если лучшая особь улучшилась
+    void generation(const std::vector<long long>& fitness, int island = 0) {
+        if (!enabled()) {
+            return;
+        }
+        add(counters_->generations, 1);
+        add(counters_->evaluations, static_cast<long long>(fitness.size()));
+        if (fitness.empty()) {
+            return;
+        }
+        sorted_fitness_.assign(fitness.begin(), fitness.end()); // буфер выделяется один раз на поток решения
+        std::sort(sorted_fitness_.begin(), sorted_fitness_.end());
+        long long sum = 0;
+        for (long long value : sorted_fitness_) {
+            sum += value;
+        }
+        long long best = sorted_fitness_.back();
+        instrumentation_->fitness({island, ++generations_, sorted_fitness_.front(), sorted_fitness_[sorted_fitness_.size() / 2],
+            static_cast<double>(sum) / sorted_fitness_.size(), best});
+        if (best_fitness_ < best) {
+            best_fitness_ = best;
+            instrumentation_->incumbent(best);
+        }
+    }
+
+private:
+    Instrumentation* instrumentation_;
+    ThreadCounters* counters_;
+    std::vector<long long> sorted_fitness_;
+    long long generations_ = 0;
+    long long best_fitness_ = -1;
+
+    static void add(std::atomic<long long>& counter, long long delta) noexcept {
+        counter.store(counter.load(std::memory_order_relaxed) + delta, std::memory_order_relaxed);
+    }
+};
+
+// время этапа решения: от создания (или next) до следующего next или уничтожения
+class PhaseTimer {
+public:
+    PhaseTimer(Instrumentation* instrumentation, Phase phase) noexcept :
+        instrumentation_(INSTRUMENTATION != 0 ? instrumentation : nullptr),
+        phase_(phase) {
+        if (instrumentation_ != nullptr) {
+            start_ = std::chrono::steady_clock::now();
+        }
+    }
+
+    PhaseTimer(const PhaseTimer&) = delete;
+    PhaseTimer& operator=(const PhaseTimer&) = delete;
+
+    ~PhaseTimer() {
+        next(phase_);
+    }
+
+    void next(Phase phase) noexcept {
+        if (instrumentation_ != nullptr) {
+            auto now = std::chrono::steady_clock::now();
+            instrumentation_->add_phase_time(phase_, now - start_);
+            start_ = now;
+        }
+        phase_ = phase;
+    }
+
+private:
+    Instrumentation* instrumentation_;
+    Phase phase_;
+    std::chrono::steady_clock::time_point start_;
+};
+
+struct StatisticsOptions {
+    bool enabled = false;
+    int interval = 0; // миллисекунд между выводами; 0 - только итог после решения
+    std::string file; // файл JSON Lines (объект на строку); пусто - текст в стандартный поток ошибок
+};
+
+// забирает из argv аргументы --stats, --stats_interval=мс, --stats_file=файл
+inline bool parse_statistics_arguments(int& argc, char* argv[], StatisticsOptions& options) {
+    int kept = 1;
+    for (int i = 1; i < argc; ++i) {
+        std::string argument = argv[i];
+        if (argument == "--stats") {
+            options.enabled = true;
+        } else if (argument.rfind("--stats_interval=", 0) == 0) {
+            auto [end, error] = std::from_chars(argument.data() + 17, argument.data() + argument.size(), options.interval);
+            if (error != std::errc() || end != argument.data() + argument.size() || options.interval < 0) {
+                std::cerr << "Error: invalid value of --stats_interval.\n";
+                return false;
+            }
+            options.enabled = true;
+        } else if (argument.rfind("--stats_file=", 0) == 0) {
+            options.file = argument.substr(13);
+            options.enabled = true;
+        } else {
+            argv[kept++] = argv[i];
+        }
+    }
+    argc = kept;
+    if (options.enabled && INSTRUMENTATION == 0) {
+        std::cerr << "Error: statistics require building with -DINSTRUMENTATION=1.\n";
+        return false;
+    }
+    return true;
+}
+
+/*
+Поток вывода статистики: каждые interval миллисекунд берет снимок Instrumentation и печатает его, скорости
+(состояний и поколений в секунду) считаются по разнице с прошлым снимком. Итоговый снимок выводится в stop.
+*/
+class StatisticsReporter {
+public:
+    StatisticsReporter(Instrumentation& instrumentation, const StatisticsOptions& options) :
+        instrumentation_(instrumentation),
+        options_(options) {
+        if (!options_.enabled) {
+            return;
+        }
+        if (!options_.file.empty()) {
+            file_.open(options_.file);
+            if (!file_.is_open()) {
+                std::cerr << "Error: can't open the file '" << options_.file << "', statistics go to stderr.\n";
+            }
+        }
+        if (0 < options_.interval) {
+            thread_ = std::thread([this]() {
+                std::unique_lock<std::mutex> lock(mutex_);
+                while (!stop_requested_) {
+                    if (!stopped_.wait_for(lock, std::chrono::milliseconds(options_.interval), [this]() { return stop_requested_; })) {
+                        report(false);
+                    }
+                }
+            });
+        }
+    }
+
+    StatisticsReporter(const StatisticsReporter&) = delete;
+    StatisticsReporter& operator=(const StatisticsReporter&) = delete;
+
+    ~StatisticsReporter() {
+        stop();
+    }
+
+    // останавливает периодический вывод и выводит итог; повторные вызовы ничего не делают
+    void stop() {
+        if (!options_.enabled || finished_) {
+            return;
+        }
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            stop_requested_ = true;
+        }
+        stopped_.notify_all();
+        if (thread_.joinable()) {
+            thread_.join();
+        }
+        report(true);
+        finished_ = true;
+    }
+
+private:
+    Instrumentation& instrumentation_;
+    StatisticsOptions options_;
+    std::ofstream file_;
+    std::thread thread_;
+    std::mutex mutex_;
+    std::condition_variable stopped_;
+    bool stop_requested_ = false;
+    bool finished_ = false;
+    StatisticsSnapshot previous_;
+
+    void report(bool final) {
+        StatisticsSnapshot snapshot = instrumentation_.snapshot();
+        double seconds = std::max(snapshot.seconds - previous_.seconds, 1e-9);
+        double expanded_per_second = (snapshot.expanded_nodes - previous_.expanded_nodes) / seconds;
+        double generations_per_second = (snapshot.generations - previous_.generations) / seconds;
+        if (file_.is_open()) {
+            write_json(snapshot, final, expanded_per_second, generations_per_second);
+        } else {
+            write_text(snapshot, final, expanded_per_second, generations_per_second);
+        }
+        previous_ = std::move(snapshot);
+    }
+
+    void write_text(const StatisticsSnapshot& snapshot, bool final, double expanded_per_second, double generations_per_second) const {
+        std::cerr << (final ? "[stats total " : "[stats ") << snapshot.seconds << " s]";
+        if (0 < snapshot.expanded_nodes) {
+            std::cerr << " expanded " << snapshot.expanded_nodes << " (" << static_cast<long long>(expanded_per_second) << "/s), pruned "
+                << snapshot.pruned_nodes << ", queue peak " << snapshot.queue_peak;
+        }
+        if (0 < snapshot.generations) {
+            std::cerr << " generations " << snapshot.generations << " (" << generations_per_second << "/s), evaluations " << snapshot.evaluations;
+        }
+        if (!snapshot.fitness.empty()) {
+            const FitnessSummary& last = snapshot.fitness.back();
+            std::cerr << ", fitness min/median/mean/max " << last.min << '/' << last.median << '/' << last.mean << '/' << last.max;
+        }
+        if (0 <= snapshot.best_price) {
+            std::cerr << ", incumbent " << snapshot.best_price << " (" << snapshot.incumbent_updates << " updates)";
+        }
+        std::cerr << ", phases:";
+        for (int i = 0; i < PHASES_COUNT; ++i) {
+            std::cerr << ' ' << phase_name(static_cast<Phase>(i)) << ' ' << snapshot.phase_seconds[i] << " s";
+        }
+        std::cerr << '\n';
+    }
+
+    void write_json(const StatisticsSnapshot& snapshot, bool final, double expanded_per_second, double generations_per_second) {
+        file_ << "{\"final\": " << (final ? "true" : "false") << ", \"seconds\": " << snapshot.seconds
+            << ", \"expanded_nodes\": " << snapshot.expanded_nodes << ", \"expanded_per_second\": " << expanded_per_second
+            << ", \"pruned_nodes\": " << snapshot.pruned_nodes << ", \"queue_peak\": " << snapshot.queue_peak
+            << ", \"generations\": " << snapshot.generations << ", \"generations_per_second\": " << generations_per_second
+            << ", \"evaluations\": " << snapshot.evaluations << ", \"incumbent_updates\": " << snapshot.incumbent_updates
+            << ", \"best_price\": " << snapshot.best_price << ", \"phases\": {";
+        for (int i = 0; i < PHASES_COUNT; ++i) {
+            file_ << (i == 0 ? "\"" : ", \"") << phase_name(static_cast<Phase>(i)) << "\": " << snapshot.phase_seconds[i];
+        }
+        file_ << "}, \"incumbents\": [";
+        for (size_t i = 0; i < snapshot.incumbents.size(); ++i) {
+            file_ << (i == 0 ? "" : ", ") << "{\"seconds\": " << snapshot.incumbents[i].seconds << ", \"price\": " << snapshot.incumbents[i].price << '}';
+        }
+        file_ << "], \"fitness\": [";
+        for (size_t i = 0; i < snapshot.fitness.size(); ++i) {
+            const FitnessSummary& summary = snapshot.fitness[i];
+            file_ << (i == 0 ? "" : ", ") << "{\"island\": " << summary.island << ", \"generation\": " << summary.generation << ", \"min\": " << summary.min
+                << ", \"median\": " << summary.median << ", \"mean\": " << summary.mean << ", \"max\": " << summary.max << '}';
+        }
+        file_ << "]}\n";
+        file_.flush();
+    }
+};
\ No newline at end of file
@@ -0,0 +1,98 @@
+#include <iostream>
+#include <string>
+#include <vector>
+#include <memory>
+#include <random>
+#include <chrono>
+#include "solvers.h"
+
+using namespace std;
+
+/*
+Все решатели в одной программе: задача загружается и готовится один раз, затем ее решает каждый выбранный решатель.
+Аргументы командной строки:
+    --solvers=имя,имя,... - решатели по порядку (greedy, dynamic_programming, branch_bound, genetic, parallel_genetic,
+    portfolio), по умолчанию все;
+    --config=файл и --имя=значение - параметры решателей, передаются всем выбранным решателям, которые их знают
+    (например, --seed=42 --islands_count=4 --threads_count=4);
+    --batch, --batch_dir=, --batch_socket=, --batch_threads= - пакетный режим для одного решателя (см. batch_service.h);
+    --reduction=0 - без предобработки задачи, --core_size=k - решателю остаются k свободных предметов вокруг критического (см. reduce_instance);
+    --time_limit=мс - срок решения для каждого решателя, по истечении выводится лучший найденный ответ;
+    --stats, --stats_interval=мс, --stats_file=файл - статистика решения при сборке с -DINSTRUMENTATION=1 (см. instrumentation.h).
+*/
+int main(int argc, char* argv[]) {
+    vector<unique_ptr<Solver>> solvers = make_solvers();
+    vector<Solver*> selected;
+    BatchOptions batch;
+    StatisticsOptions statistics;
+    if (!parse_batch_arguments(argc, argv, batch) || !parse_statistics_arguments(argc, argv, statistics) || !select_solvers(argc, argv, solvers, selected)) {
+        return 1;
+    }
+    if (batch.source != BatchSource::none && selected.size() != 1) {
+        cerr << "Error: batch mode runs a single solver, choose it with --solvers=name.\n";
+        return 1;
+    }
+
+    string seed = to_string((random_device())()); // зерно по умолчанию для решателей, у которых оно есть
+    for (int i = 1; i < argc; ++i) {
+        string argument = argv[i];
+        if (argument.rfind("--seed=", 0) == 0) {
+            seed = argument.substr(7);
+        }
+    }
+    bool seeded = false;
+    for (Solver* solver : selected) {
+        seeded = solver->set_parameter("seed", seed) == ParameterStatus::applied || seeded;
+    }
+    if (!parse_arguments(selected, argc, argv)) {
+        return 1;
+    }
+    Instrumentation instrumentation;
+    StatisticsReporter reporter(instrumentation, statistics);
+    for (Solver* solver : selected) {
+        solver->instrumentation = statistics.enabled ? &instrumentation : nullptr;
+    }
+    if (seeded) {
+        (batch.source != BatchSource::none ? cerr : cout) << "Seed: " << seed << '\n';
+    }
+
+    if (batch.source != BatchSource::none) {
+        return run_batch(batch, *selected[0]);
+    }
+
+    bool sort = false; // сортировка нужна, только если она нужна хотя бы одному решателю
+    for (Solver* solver : selected) {
+        sort = sort || solver->needs_sorted_items();
+    }
+    Instance instance;
+    if (!input_data(instance, sort)) {
+        return 1;
+    }
+    for (Solver* solver : selected) {
+        cancel_on_interrupt(*solver); // Ctrl+C останавливает текущий решатель, остальные сразу отдают начальный ответ
+    }
+    vector<Solution> solutions;
+    vector<chrono::nanoseconds> times;
+    for (Solver* solver : selected) {
+        ReductionStatistics reduction;
+        auto start = chrono::high_resolution_clock::now();
+        solutions.push_back(solver->solve(instance, &reduction));
+        times.push_back(chrono::high_resolution_clock::now() - start);
+        if (1 < selected.size()) {
+            cout << "\nSolver: " << solver->name() << '\n';
+        }
+        if (solver->reduction && instance.sorted) {
+            print_reduction(reduction);
+        }
+        print_solution(solutions.back(), times.back());
+    }
+    reporter.stop();
+    if (1 < selected.size()) {
+        cout << "\nsolver\tprice\tmilliseconds\n";
+        for (size_t i = 0; i < selected.size(); ++i) {
+            cout << selected[i]->name() << '\t' << solutions[i].price << '\t' << chrono::duration<double, milli>(times[i]).count() << '\n';
+        }
+    }
+    wait_for_exit();
+    return 0;
+}
\ No newline at end of file
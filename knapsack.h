@@ -0,0 +1,973 @@
+#pragma once
+
+/*
+Общая часть всех решателей.
+
+Instance - задача в виде структуры массивов. Она готовится один раз (prepare_instance): считаются удельные стоимости
+и порядок предметов по их убыванию (sort_instance, для больших задач - всеми потоками), отсортированные стоимости и веса
+лежат отдельными массивами. Решателю без порядка (Solver::needs_sorted_items) задача готовится без сортировки. Дальше задача только
+читается, поэтому ее можно решать несколькими решателями подряд или одновременно без повторной подготовки.
+
+Solver - интерфейс решателя: имя, параметры по имени (из командной строки или файла настроек) и solve(const Instance&).
+Перед решением задача уменьшается (reduce_instance: лишние предметы, закрепление по оценкам, ядро), сам алгоритм
+наследник реализует в solve_instance и получает уже уменьшенную задачу.
+Каждый алгоритм лежит в своем заголовке и своем пространстве имен (greedy.h, dynamic_programming.h, branch_bound.h,
+genetic.h, parallel_genetic.h; общее ядро обоих ГА - в genetic_common.h) вместе со своим наследником Solver, список
+всех решателей - в solvers.h. Отдельные программы (greedy.cpp и т. д.) собирают один решатель, knapsack.cpp - все
+сразу с выбором при запуске, benchmark_suite.cpp - набор замеров на сгенерированных задачах (instance_generators.h).
+Задачи с несколькими ограничениями, кратностями и классами - в extended_instance.h, их решают только точные алгоритмы.
+Для задачи, которая меняется понемногу между решениями, - сессия в solver_session.h: изменения без повторной подготовки
+и повторное решение с теплым стартом от прошлого ответа.
+Портфель (portfolio.h) решает одну задачу методом ветвей и границ и параллельным ГА одновременно, деля между ними ядра
+и общий рекорд (SharedIncumbent).
+*/
+
+#include <iostream>
+#include <fstream>
+#include <string>
+#include <vector>
+#include <algorithm>
+#include <numeric>
+#include <chrono>
+#include <charconv>
+#include <functional>
+#include <atomic>
+#include <mutex>
+#include <csignal>
+#include <cstdint>
+#if defined(_OPENMP)
+#include <omp.h>
+#endif
+#include "instance_loader.h"
+#include "batch_service.h"
+#include "instrumentation.h"
+
+#if !defined(REDUCTION)
+#define REDUCTION 1 // предобработка задачи перед решением (reduce_instance); 0 - решатель получает задачу как есть
+#endif
+#define CORE_SIZE 0 // число свободных предметов вокруг критического, которые остаются решателю; 0 - без выделения ядра
+#define PARALLEL_SORT_MIN_COUNT (1 << 20) // с какого числа предметов порядок по удельной стоимости сортируется всеми потоками OpenMP
+
+struct Item {
+    int price;
+    int weight;
+};
+
+struct Instance {
+    int max_weight = 0;
+    int count = 0; // число предметов
+    std::vector<int> prices; // во входном порядке
+    std::vector<int> weights;
+    std::vector<double> specific_prices; // удельные стоимости price / weight
+    bool sorted = false; // посчитаны ли order, sorted_prices и sorted_weights (см. sort_instance)
+    std::vector<int> order; // индексы предметов по убыванию удельной стоимости, при равенстве - по возрастанию индекса
+    std::vector<int> sorted_prices; // sorted_prices[i] = prices[order[i]]
+    std::vector<int> sorted_weights; // sorted_weights[i] = weights[order[i]]
+};
+
+// порядок предметов в instance.order: по убыванию удельной стоимости, при равенстве - по возрастанию индекса
+inline bool precedes(const Instance& instance, int lhs, int rhs) noexcept {
+    const std::vector<double>& specific_prices = instance.specific_prices;
+    return specific_prices[rhs] < specific_prices[lhs] || (specific_prices[rhs] == specific_prices[lhs] && lhs < rhs);
+}
+
+/*
+Сортировка слиянием всеми потоками OpenMP: куски сортируются параллельно, затем сливаются попарно, на каждом шаге
+тоже параллельно. Результат тот же, что у std::sort, если порядок строгий (как precedes - при равенстве решает индекс).
+*/
+template<typename Iterator, typename Compare>
+void parallel_sort(Iterator first, Iterator last, Compare compare) {
+#if defined(_OPENMP)
+    long long count = last - first;
+    int chunks_count = omp_get_max_threads();
+    if (PARALLEL_SORT_MIN_COUNT <= count && 1 < chunks_count) {
+        long long chunk = (count + chunks_count - 1) / chunks_count;
+#pragma omp parallel for schedule(static, 1)
+        for (int i = 0; i < chunks_count; ++i) {
+            std::sort(first + std::min(count, i * chunk), first + std::min(count, (i + 1) * chunk), compare);
+        }
+        for (long long width = chunk; width < count; width *= 2) {
+            long long pairs_count = (count + 2 * width - 1) / (2 * width);
+#pragma omp parallel for schedule(dynamic, 1)
+            for (long long i = 0; i < pairs_count; ++i) {
+                long long low = 2 * width * i;
+                std::inplace_merge(first + low, first + std::min(count, low + width), first + std::min(count, low + 2 * width), compare);
+            }
+        }
+        return;
+    }
+#endif
+    std::sort(first, last, compare);
+}
+
+// порядок предметов по удельной стоимости и отсортированные массивы; для большого числа предметов - всеми потоками
+inline void sort_instance(Instance& instance) {
+    const int count = instance.count;
+    instance.order.resize(count);
+    std::iota(instance.order.begin(), instance.order.end(), 0);
+    parallel_sort(instance.order.begin(), instance.order.end(), [&](int lhs, int rhs) { return precedes(instance, lhs, rhs); });
+    instance.sorted_prices.resize(count);
+    instance.sorted_weights.resize(count);
+#pragma omp parallel for if (PARALLEL_SORT_MIN_COUNT <= count)
+    for (int i = 0; i < count; ++i) {
+        instance.sorted_prices[i] = instance.prices[instance.order[i]];
+        instance.sorted_weights[i] = instance.weights[instance.order[i]];
+    }
+    instance.sorted = true;
+}
+
+/*
+Заполняет instance; буферы instance переиспользуются, поэтому в пакетном режиме память выделяется только под рост задачи.
+sort = false - без сортировки (O(n) вместо O(n log n)) для решателей, которым порядок не нужен (Solver::needs_sorted_items);
+остальным Solver::solve отсортирует копию задачи сам.
+*/
+inline void prepare_instance(int max_weight, const int* prices, const int* weights, int count, Instance& instance, bool sort = true) {
+    instance.max_weight = max_weight;
+    instance.count = count;
+    instance.prices.assign(prices, prices + count);
+    instance.weights.assign(weights, weights + count);
+    instance.specific_prices.resize(count);
+    for (int i = 0; i < count; ++i) {
+        instance.specific_prices[i] = static_cast<double>(prices[i]) / weights[i];
+    }
+    instance.sorted = false;
+    if (sort) {
+        sort_instance(instance);
+    }
+}
+
+inline void prepare_instance(int max_weight, const std::vector<Item>& items, Instance& instance, bool sort = true) {
+    std::vector<int> prices(items.size()), weights(items.size());
+    for (size_t i = 0; i < items.size(); ++i) {
+        prices[i] = items[i].price;
+        weights[i] = items[i].weight;
+    }
+    prepare_instance(max_weight, prices.data(), weights.data(), static_cast<int>(items.size()), instance, sort);
+}
+
+inline void prepare_instance(const LoadedInstance& loaded, Instance& instance, bool sort = true) {
+    prepare_instance(loaded.max_weight, loaded.prices, loaded.weights, loaded.count, instance, sort);
+}
+
+struct Solution {
+    long long price = 0; // суммарная стоимость
+    std::vector<int> items; // индексы взятых предметов во входных данных (по возрастанию)
+    bool stopped = false; // решение прервано по сроку или отмене: price - лучший найденный к этому моменту ответ
+    long long upper_bound = -1; // верхняя оценка оптимума, если решатель ее знает (-1 - неизвестна); у точного ответа равна price
+};
+
+using IncumbentCallback = std::function<void(const Solution&)>; // вызывается из потоков решателя и не должен бросать исключения
+
+/*
+Общий рекорд нескольких решателей одной задачи (portfolio.h): каждый предлагает ему свои рекорды и время от времени
+читает чужие. Цена и номер версии атомарны, поэтому проверка "появилось ли что-то новое" ничего не блокирует,
+а список предметов копируется под мьютексом только после смены версии.
+*/
+class SharedIncumbent {
+public:
+    // true, если решение лучше общего рекорда и стало им
+    bool offer(const Solution& solution) {
+        if (solution.price <= price()) {
+            return false;
+        }
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (solution.price <= best_.price) {
+            return false;
+        }
+        best_.price = solution.price;
+        best_.items = solution.items;
+        price_.store(solution.price, std::memory_order_relaxed);
+        version_.fetch_add(1, std::memory_order_release);
+        return true;
+    }
+
+    long long price() const noexcept {
+        return price_.load(std::memory_order_relaxed);
+    }
+
+    // растет с каждым новым рекордом; 0 - рекорда еще нет
+    long long version() const noexcept {
+        return version_.load(std::memory_order_acquire);
+    }
+
+    Solution best() const {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return best_;
+    }
+
+private:
+    mutable std::mutex mutex_;
+    Solution best_;
+    std::atomic<long long> price_{0};
+    std::atomic<long long> version_{0};
+};
+
+/*
+Ограничения и уведомления одного решения: срок, внешняя отмена и обратный вызов для каждого улучшенного ответа.
+Решатель время от времени спрашивает stop_requested и после остановки возвращает лучший найденный ответ
+с Solution::stopped = true. Остановка необратима, поэтому потоки одного решения останавливаются согласованно.
+*/
+class SolveControl {
+public:
+    explicit SolveControl(std::chrono::milliseconds time_limit = std::chrono::milliseconds(0), const std::atomic<bool>* cancelled = nullptr,
+        IncumbentCallback on_incumbent = nullptr) :
+        has_deadline_(0 < time_limit.count()),
+        deadline_(std::chrono::steady_clock::now() + time_limit),
+        cancelled_(cancelled),
+        on_incumbent_(std::move(on_incumbent)) {}
+
+    SolveControl(const SolveControl&) = delete;
+    SolveControl& operator=(const SolveControl&) = delete;
+
+    bool stop_requested() noexcept {
+        if (stopped_.load(std::memory_order_relaxed)) {
+            return true;
+        }
+        if ((cancelled_ != nullptr && cancelled_->load(std::memory_order_relaxed)) || (has_deadline_ && deadline_ <= std::chrono::steady_clock::now())
+            || (parent_ != nullptr && parent_->stop_requested())) {
+            stopped_.store(true, std::memory_order_relaxed);
+            return true;
+        }
+        return false;
+    }
+
+    // нужен ли решателю список предметов каждого нового рекорда (собирать его без обратного вызова незачем)
+    bool publishes() const noexcept {
+        return static_cast<bool>(on_incumbent_);
+    }
+
+    // решения для теплого старта в индексах решаемой задачи, уже допустимые (см. Solver::solve)
+    const std::vector<std::vector<int>>& seeds() const noexcept {
+        return seeds_;
+    }
+
+    void set_seeds(std::vector<std::vector<int>> seeds) noexcept {
+        seeds_ = std::move(seeds);
+    }
+
+    // собирает ли вызывающий решения решателя для следующего теплого старта (например, последнее поколение ГА)
+    bool collects_pool() const noexcept {
+        return pool_ != nullptr;
+    }
+
+    void set_pool(std::vector<std::vector<int>>* pool) noexcept {
+        pool_ = pool;
+    }
+
+    // вызывается из одного потока
+    void add_to_pool(std::vector<int> items) {
+        if (pool_ != nullptr) {
+            pool_->push_back(std::move(items));
+        }
+    }
+
+    // решение - часть составного решения (portfolio.h): его срок и отмена останавливают и это решение
+    void set_parent(SolveControl* parent) noexcept {
+        parent_ = parent;
+    }
+
+    // общий рекорд решателей, одновременно решающих ту же задачу, или nullptr; решатель может отсекать и скрещивать по нему
+    SharedIncumbent* shared() const noexcept {
+        return shared_;
+    }
+
+    void set_shared(SharedIncumbent* shared) noexcept {
+        shared_ = shared;
+    }
+
+    // передает ответ обратному вызову, если он лучше всех переданных раньше; вызовы из разных потоков идут по очереди
+    void publish(const Solution& solution) {
+        if (!publishes()) {
+            return;
+        }
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (published_price_ < solution.price) {
+            published_price_ = solution.price;
+            on_incumbent_(solution);
+        }
+    }
+
+private:
+    bool has_deadline_;
+    std::chrono::steady_clock::time_point deadline_;
+    const std::atomic<bool>* cancelled_;
+    std::atomic<bool> stopped_{false};
+    IncumbentCallback on_incumbent_;
+    std::mutex mutex_;
+    long long published_price_ = -1;
+    std::vector<std::vector<int>> seeds_;
+    std::vector<std::vector<int>>* pool_ = nullptr;
+    SolveControl* parent_ = nullptr;
+    SharedIncumbent* shared_ = nullptr;
+};
+
+/*
+Проверка остановки из горячего цикла: часы читаются, только когда накопится interval единиц работы
+(состояний, ячеек динамики), а после остановки ответ запоминается. Без SolveControl (nullptr) проверка всегда ложна.
+*/
+class StopPoller {
+public:
+    StopPoller(SolveControl* control, long long interval) noexcept :
+        control_(control),
+        interval_(interval) {}
+
+    bool stop_requested(long long work = 1) noexcept {
+        if (control_ == nullptr) {
+            return false;
+        }
+        if (stopped_) {
+            return true;
+        }
+        work_ += work;
+        if (work_ < interval_) {
+            return false;
+        }
+        work_ = 0;
+        stopped_ = control_->stop_requested();
+        return stopped_;
+    }
+
+    bool stopped() const noexcept {
+        return stopped_;
+    }
+
+private:
+    SolveControl* control_;
+    long long interval_;
+    long long work_ = 0;
+    bool stopped_ = false;
+};
+
+// число из строки целиком, без исключений
+template<typename T>
+bool parse_number(const std::string& text, T& value) noexcept {
+    auto [end, error] = std::from_chars(text.data(), text.data() + text.size(), value);
+    return error == std::errc() && end == text.data() + text.size();
+}
+
+// сколько предметов убрал каждый шаг предобработки (reduce_instance)
+struct ReductionStatistics {
+    int count = 0; // предметов в исходной задаче
+    int oversize = 0; // тяжелее рюкзака или ничего не стоят
+    int fixed = 0; // закреплены проверкой оценок
+    int outside_core = 0; // закреплены жадным значением вне ядра
+    int reduced_count = 0; // осталось решателю
+    std::chrono::nanoseconds time{0};
+};
+
+// задача после предобработки и то, что нужно, чтобы перевести ее ответ в ответ исходной задачи
+struct Reduction {
+    Instance instance; // свободные предметы; вместимость уменьшена на вес закрепленных взятыми
+    std::vector<int> original; // original[i] - индекс i-го предмета instance в исходной задаче
+    std::vector<int> taken; // закрепленные взятыми, индексы исходной задачи
+    long long taken_price = 0;
+    Solution greedy; // жадный ответ исходной задачи - нижняя оценка для проверок
+    long long outside_bound = -1; // оценка ответов, не совпадающих с жадным вне ядра; -1 - ядро не выделялось
+};
+
+/*
+Предобработка перед любым решателем (предметы рассматриваются в порядке instance.order):
+1. Предметы тяжелее рюкзака и предметы без стоимости ни в один ответ не нужны - они убираются.
+2. Проверка оценок (Мартелло - Тот): для каждого предмета считается оценка Данцига при обратном жадному значении
+   (предмет до критического не берется, после - берется). Если она не больше жадного ответа L, то в любом ответе
+   лучше L предмет имеет жадное значение и закрепляется; сам L запоминается и возвращается, если решатель не найдет лучше.
+   Оценки с закрепленным предметом считаются двоичным поиском по префиксным суммам, всего O(n log n).
+3. Ядро (core_size > 0): из свободных предметов остаются core_size вокруг критического, остальные получают жадное
+   значение. Это эвристика, но оценки шага 2 для предметов вне ядра ограничивают все ответы, отличающиеся от ядра,
+   поэтому верхняя оценка ответа остается честной, а если ответ ядра не меньше их - он оптимален.
+false - задача не подходит для предобработки (отрицательные значения, нулевой вес или задача не отсортирована) и решается как есть.
+*/
+inline bool reduce_instance(const Instance& instance, int core_size, Reduction& reduction, ReductionStatistics& statistics) {
+    const int max_weight = instance.max_weight;
+    statistics = ReductionStatistics();
+    statistics.count = instance.count;
+    statistics.reduced_count = instance.count;
+    if (max_weight < 0 || !instance.sorted) {
+        return false;
+    }
+    for (int i = 0; i < instance.count; ++i) {
+        if (instance.weights[i] <= 0 || instance.prices[i] < 0) {
+            return false;
+        }
+    }
+
+    std::vector<int> kept; // позиции в instance.order нужных предметов
+    for (int i = 0; i < instance.count; ++i) {
+        if (instance.sorted_weights[i] <= max_weight && 0 < instance.sorted_prices[i]) {
+            kept.push_back(i);
+        }
+    }
+    const int kept_count = static_cast<int>(kept.size());
+    statistics.oversize = instance.count - kept_count;
+    std::vector<long long> prefix_price(kept_count + 1, 0), prefix_weight(kept_count + 1, 0);
+    for (int k = 0; k < kept_count; ++k) {
+        prefix_price[k + 1] = prefix_price[k] + instance.sorted_prices[kept[k]];
+        prefix_weight[k + 1] = prefix_weight[k] + instance.sorted_weights[kept[k]];
+    }
+    int critical = static_cast<int>(std::upper_bound(prefix_weight.begin(), prefix_weight.end(), max_weight) - prefix_weight.begin()) - 1;
+
+    reduction.greedy = Solution();
+    long long weight = 0;
+    for (int k = 0; k < kept_count; ++k) {
+        if (weight + instance.sorted_weights[kept[k]] <= max_weight) {
+            reduction.greedy.price += instance.sorted_prices[kept[k]];
+            reduction.greedy.items.push_back(instance.order[kept[k]]);
+            weight += instance.sorted_weights[kept[k]];
+        }
+    }
+    std::sort(reduction.greedy.items.begin(), reduction.greedy.items.end());
+    const long long lower_bound = reduction.greedy.price;
+
+    // часть предмета в позиции k по удельной стоимости на оставшуюся вместимость
+    auto fraction = [&](int k, long long weight_left) {
+        return k < kept_count ? weight_left * instance.sorted_prices[kept[k]] / instance.sorted_weights[kept[k]] : 0;
+    };
+    // оценка Данцига при обратном жадному значении предмета в позиции k
+    auto flipped_bound = [&](int k) {
+        long long price = instance.sorted_prices[kept[k]];
+        long long weight = instance.sorted_weights[kept[k]];
+        if (k < critical) { // без предмета: префикс продолжается за критический
+            int last = static_cast<int>(std::upper_bound(prefix_weight.begin() + critical, prefix_weight.end(), max_weight + weight) - prefix_weight.begin()) - 1;
+            return prefix_price[last] - price + fraction(last, max_weight + weight - prefix_weight[last]);
+        }
+        int last = static_cast<int>(std::upper_bound(prefix_weight.begin(), prefix_weight.begin() + critical + 1, max_weight - weight) - prefix_weight.begin()) - 1;
+        return price + prefix_price[last] + fraction(last, max_weight - weight - prefix_weight[last]); // last < k, см. определение критического
+    };
+
+    std::vector<int> free_items; // позиции в kept
+    std::vector<long long> free_bounds;
+    reduction.taken.clear();
+    long long taken_weight = 0, taken_price = 0;
+    for (int k = 0; k < kept_count; ++k) {
+        long long bound = flipped_bound(k);
+        if (lower_bound < bound) {
+            free_items.push_back(k);
+            free_bounds.push_back(bound);
+        } else if (k < critical) {
+            reduction.taken.push_back(instance.order[kept[k]]);
+            taken_weight += instance.sorted_weights[kept[k]];
+            taken_price += instance.sorted_prices[kept[k]];
+        }
+    }
+    statistics.fixed = kept_count - static_cast<int>(free_items.size());
+
+    reduction.outside_bound = -1;
+    int first = 0, last = static_cast<int>(free_items.size());
+    if (0 < core_size && core_size < last) {
+        int middle = static_cast<int>(std::lower_bound(free_items.begin(), free_items.end(), critical) - free_items.begin());
+        first = std::clamp(middle - core_size / 2, 0, last - core_size);
+        for (int i = 0; i < static_cast<int>(free_items.size()); ++i) {
+            if (first <= i && i < first + core_size) {
+                continue;
+            }
+            reduction.outside_bound = std::max(reduction.outside_bound, free_bounds[i]);
+            if (i < first) { // до ядра - только предметы до критического, они помещаются все вместе с закрепленными
+                reduction.taken.push_back(instance.order[kept[free_items[i]]]);
+                taken_weight += instance.sorted_weights[kept[free_items[i]]];
+                taken_price += instance.sorted_prices[kept[free_items[i]]];
+            }
+        }
+        last = first + core_size;
+        statistics.outside_core = static_cast<int>(free_items.size()) - core_size;
+    }
+    std::sort(reduction.taken.begin(), reduction.taken.end());
+    reduction.taken_price = taken_price;
+
+    const int reduced_max_weight = static_cast<int>(max_weight - taken_weight);
+    reduction.original.clear();
+    for (int i = first; i < last; ++i) {
+        if (instance.sorted_weights[kept[free_items[i]]] <= reduced_max_weight) { // после закрепления взятых уже не помещается
+            reduction.original.push_back(instance.order[kept[free_items[i]]]);
+        } else {
+            ++statistics.fixed;
+        }
+    }
+    std::sort(reduction.original.begin(), reduction.original.end()); // входной порядок, чтобы равные удельные стоимости упорядочились как в исходной задаче
+    std::vector<int> prices(reduction.original.size()), weights(reduction.original.size());
+    for (size_t i = 0; i < reduction.original.size(); ++i) {
+        prices[i] = instance.prices[reduction.original[i]];
+        weights[i] = instance.weights[reduction.original[i]];
+    }
+    prepare_instance(reduced_max_weight, prices.data(), weights.data(), static_cast<int>(prices.size()), reduction.instance);
+    statistics.reduced_count = reduction.instance.count;
+    return true;
+}
+
+// предметы исходной задачи по предметам задачи после предобработки (вместе с закрепленными взятыми)
+inline std::vector<int> restore_items(const Reduction& reduction, const std::vector<int>& reduced) {
+    std::vector<int> items = reduction.taken;
+    for (int index : reduced) {
+        items.push_back(reduction.original[index]);
+    }
+    std::sort(items.begin(), items.end());
+    return items;
+}
+
+// ответ исходной задачи по ответу задачи после предобработки; жадный ответ, если он лучше
+inline Solution restore_solution(const Reduction& reduction, const Solution& reduced) {
+    Solution solution;
+    solution.stopped = reduced.stopped;
+    solution.price = reduced.price + reduction.taken_price;
+    solution.items = restore_items(reduction, reduced.items);
+    if (solution.price < reduction.greedy.price) {
+        solution.price = reduction.greedy.price;
+        solution.items = reduction.greedy.items;
+    }
+    if (0 <= reduced.upper_bound) { // ответы, отвергнутые проверками, не лучше жадного, а отличающиеся от ядра - не лучше outside_bound
+        solution.upper_bound = std::max({reduced.upper_bound + reduction.taken_price, reduction.outside_bound, solution.price});
+    }
+    return solution;
+}
+
+/*
+Делает набор предметов допустимым (например, прошлый ответ после изменения стоимостей и весов): убирает повторы и чужие
+индексы, при перевесе выбрасывает предметы с наименьшей удельной стоимостью, затем жадно дозаполняет рюкзак в порядке
+instance.order, если он посчитан. Возвращает стоимость набора, items - по возрастанию.
+*/
+inline long long repair_solution(const Instance& instance, std::vector<int>& items) {
+    std::sort(items.begin(), items.end());
+    items.erase(std::unique(items.begin(), items.end()), items.end());
+    items.erase(std::remove_if(items.begin(), items.end(), [&](int item) { return item < 0 || instance.count <= item; }), items.end());
+    long long weight = 0;
+    for (int item : items) {
+        weight += instance.weights[item];
+    }
+    if (instance.max_weight < weight) {
+        std::sort(items.begin(), items.end(), [&](int lhs, int rhs) { return precedes(instance, lhs, rhs); });
+        while (instance.max_weight < weight && !items.empty()) {
+            weight -= instance.weights[items.back()];
+            items.pop_back();
+        }
+    }
+    if (instance.sorted) {
+        std::vector<char> taken(instance.count, 0);
+        for (int item : items) {
+            taken[item] = 1;
+        }
+        for (int i = 0; i < instance.count && weight < instance.max_weight; ++i) {
+            int item = instance.order[i];
+            if (!taken[item] && weight + instance.weights[item] <= instance.max_weight) {
+                items.push_back(item);
+                weight += instance.weights[item];
+            }
+        }
+    }
+    std::sort(items.begin(), items.end());
+    long long price = 0;
+    for (int item : items) {
+        price += instance.prices[item];
+    }
+    return price;
+}
+
+// reduced_index[item] - индекс предмета item исходной задачи (original_count предметов) в задаче после предобработки
+// или -1, если он закреплен или убран
+inline std::vector<int> reduced_indices(const Reduction& reduction, int original_count) {
+    std::vector<int> reduced_index(original_count, -1);
+    for (int i = 0; i < reduction.instance.count; ++i) {
+        reduced_index[reduction.original[i]] = i;
+    }
+    return reduced_index;
+}
+
+// решения теплого старта исходной задачи -> допустимые решения задачи после предобработки (reduced_index - см. reduced_indices)
+inline std::vector<std::vector<int>> reduce_solutions(const Reduction& reduction, const std::vector<int>& reduced_index,
+    const std::vector<std::vector<int>>& solutions) {
+    const int original_count = static_cast<int>(reduced_index.size());
+    std::vector<std::vector<int>> reduced(solutions.size());
+    for (size_t k = 0; k < solutions.size(); ++k) {
+        for (int item : solutions[k]) {
+            if (0 <= item && item < original_count && 0 <= reduced_index[item]) { // закрепленные и убранные предметы решателю не нужны
+                reduced[k].push_back(reduced_index[item]);
+            }
+        }
+        repair_solution(reduction.instance, reduced[k]);
+    }
+    return reduced;
+}
+
+/*
+Пул решений для теплого старта (см. Solver::solve): последние решения решателя в индексах задачи, которую он решал,
+и перевод этих индексов в исходную задачу. Решения не переводятся в исходную задачу после каждого решения (у ГА это
+все поколение, и в каждом решении были бы все закрепленные предметы), а переводятся сразу в индексы следующей решаемой
+задачи, когда она известна: закрепленные прошлой предобработкой входят во все решения и переводятся один раз.
+*/
+struct SolutionPool {
+    std::vector<std::vector<int>> solutions; // в индексах решенной задачи
+    bool reduced = false; // решалась задача после предобработки; иначе индексы - индексы исходной задачи
+    std::vector<int> original; // при reduced: original[i] - индекс i-го предмета решенной задачи в исходной
+    std::vector<int> taken; // при reduced: закрепленные взятыми, индексы исходной задачи, входят в каждое решение
+
+    bool empty() const noexcept {
+        return solutions.empty();
+    }
+
+    void clear() noexcept {
+        solutions.clear();
+        reduced = false;
+        original.clear();
+        taken.clear();
+    }
+
+    /*
+    Решения в индексах новой задачи, пока не допустимые (их чинит repair_solution): index[item] - индекс предмета item
+    исходной задачи в новой или -1, если он новой задаче не нужен; index == nullptr - новая задача и есть исходная
+    (original_count предметов). Решения исходной задачи, которая с тех пор изменилась, переводятся так же.
+    */
+    std::vector<std::vector<int>> translate(int original_count, const std::vector<int>* index) const {
+        auto to_new = [&](int item) {
+            return item < 0 || original_count <= item ? -1 : index == nullptr ? item : (*index)[item];
+        };
+        std::vector<int> common;
+        if (reduced) {
+            for (int item : taken) {
+                if (int new_item = to_new(item); 0 <= new_item) {
+                    common.push_back(new_item);
+                }
+            }
+        }
+        std::vector<std::vector<int>> translated(solutions.size(), common);
+        for (size_t k = 0; k < solutions.size(); ++k) {
+            for (int item : solutions[k]) {
+                if (reduced) {
+                    item = 0 <= item && item < static_cast<int>(original.size()) ? original[item] : -1;
+                }
+                if (int new_item = to_new(item); 0 <= new_item) {
+                    translated[k].push_back(new_item);
+                }
+            }
+        }
+        return translated;
+    }
+};
+
+inline void print_reduction(const ReductionStatistics& statistics) {
+    std::cout << "Reduction: " << statistics.count << " -> " << statistics.reduced_count << " items (oversize " << statistics.oversize
+        << ", fixed " << statistics.fixed << ", outside core " << statistics.outside_core << "), "
+        << std::chrono::duration<double, std::milli>(statistics.time).count() << " milliseconds\n";
+}
+
+enum class ParameterStatus {
+    applied,
+    unknown, // у решателя нет такого параметра
+    invalid // недопустимое значение
+};
+
+class Solver {
+public:
+    Instrumentation* instrumentation = nullptr; // если не nullptr, решатель пишет сюда счетчики (при сборке с INSTRUMENTATION = 1)
+    std::chrono::milliseconds time_limit{0}; // срок одного решения, параметр time_limit; 0 - без ограничения
+    const std::atomic<bool>* cancelled = nullptr; // если не nullptr, решение останавливается, когда здесь true
+    IncumbentCallback on_incumbent; // если задан, получает каждый улучшенный ответ во время решения
+    bool reduction = REDUCTION; // предобработка перед решением, параметр reduction (0 или 1)
+    int core_size = CORE_SIZE; // параметр core_size, см. reduce_instance
+
+    virtual ~Solver() = default;
+
+    virtual const char* name() const noexcept = 0;
+
+    // общие параметры всех решателей (time_limit - миллисекунды, reduction, core_size), остальные - параметры конкретного решателя
+    ParameterStatus set_parameter(const std::string& name, const std::string& value) {
+        bool parsed;
+        long long number;
+        if (name == "time_limit") {
+            parsed = parse_number(value, number) && 0 <= number;
+            time_limit = parsed ? std::chrono::milliseconds(number) : time_limit;
+        } else if (name == "reduction") {
+            parsed = parse_number(value, number) && (number == 0 || number == 1);
+            reduction = parsed ? number == 1 : reduction;
+        } else if (name == "core_size") {
+            parsed = parse_number(value, core_size) && 0 <= core_size;
+        } else {
+            return set_solver_parameter(name, value);
+        }
+        return parsed ? ParameterStatus::applied : ParameterStatus::invalid;
+    }
+
+    // нужен ли решателю порядок предметов (Instance::sorted); если нет, задачу можно готовить без сортировки
+    virtual bool needs_sorted_items() const noexcept {
+        return true;
+    }
+
+    // сообщение о несовместимых значениях параметров или nullptr; проверяется после разбора всех параметров
+    virtual const char* check_parameters() const noexcept {
+        return nullptr;
+    }
+
+    /*
+    Решатель при решении не меняется, поэтому один решатель может решать несколько задач одновременно.
+    При reduction задача сначала уменьшается (reduce_instance), решатель решает оставшуюся задачу, и ответ, как и
+    рекорды для on_incumbent, переводится в индексы исходной задачи. statistics - если не nullptr, сюда пишется,
+    сколько предметов убрала предобработка.
+    Теплый старт (см. SolverSession): seeds - решения похожей задачи, они чинятся (repair_solution) и передаются решателю
+    через SolveControl::seeds; pool - если не nullptr, его решения (пул прошлого решения) передаются туда же после seeds,
+    а сам пул заменяется последними решениями решателя для следующего раза.
+    */
+    Solution solve(const Instance& instance, ReductionStatistics* statistics = nullptr, const std::vector<std::vector<int>>* seeds = nullptr,
+        SolutionPool* pool = nullptr) const {
+        if (!instance.sorted && needs_sorted_items()) {
+            Instance sorted_instance = instance;
+            sort_instance(sorted_instance);
+            return solve(sorted_instance, statistics, seeds, pool);
+        }
+        Reduction reduced;
+        ReductionStatistics reduction_statistics;
+        reduction_statistics.count = reduction_statistics.reduced_count = instance.count;
+        bool reduced_instance = false;
+        if (reduction) {
+            PhaseTimer phase(instrumentation, Phase::preparation);
+            auto start = std::chrono::steady_clock::now();
+            reduced_instance = reduce_instance(instance, core_size, reduced, reduction_statistics);
+            reduction_statistics.time = std::chrono::steady_clock::now() - start;
+        }
+        if (statistics != nullptr) {
+            *statistics = reduction_statistics;
+        }
+        if (!reduced_instance) {
+            SolveControl control(time_limit, cancelled, on_incumbent);
+            if (seeds != nullptr || (pool != nullptr && !pool->empty())) {
+                std::vector<std::vector<int>> repaired;
+                if (seeds != nullptr) {
+                    repaired = *seeds;
+                }
+                if (pool != nullptr) {
+                    std::vector<std::vector<int>> pooled = pool->translate(instance.count, nullptr);
+                    repaired.insert(repaired.end(), std::make_move_iterator(pooled.begin()), std::make_move_iterator(pooled.end()));
+                }
+                for (std::vector<int>& items : repaired) {
+                    repair_solution(instance, items);
+                }
+                control.set_seeds(std::move(repaired));
+            }
+            if (pool != nullptr) {
+                pool->clear();
+                control.set_pool(&pool->solutions);
+            }
+            return solve_instance(instance, control);
+        }
+        if (on_incumbent) {
+            on_incumbent(reduced.greedy);
+        }
+        IncumbentCallback restored_incumbent = nullptr;
+        if (on_incumbent) { // рекорды хуже жадного ответа, уже переданного выше, не передаются
+            restored_incumbent = [&](const Solution& solution) {
+                if (reduced.greedy.price < solution.price + reduced.taken_price) {
+                    on_incumbent(restore_solution(reduced, solution));
+                }
+            };
+        }
+        SolveControl control(time_limit, cancelled, restored_incumbent);
+        if (seeds != nullptr || (pool != nullptr && !pool->empty())) {
+            std::vector<int> reduced_index = reduced_indices(reduced, instance.count);
+            std::vector<std::vector<int>> reduced_seeds;
+            if (seeds != nullptr) {
+                reduced_seeds = reduce_solutions(reduced, reduced_index, *seeds);
+            }
+            if (pool != nullptr) {
+                for (std::vector<int>& items : pool->translate(instance.count, &reduced_index)) {
+                    repair_solution(reduced.instance, items);
+                    reduced_seeds.push_back(std::move(items));
+                }
+            }
+            control.set_seeds(std::move(reduced_seeds));
+        }
+        if (pool != nullptr) {
+            pool->clear();
+            control.set_pool(&pool->solutions);
+        }
+        Solution solution = restore_solution(reduced, solve_instance(reduced.instance, control));
+        if (pool != nullptr) { // решения остаются в индексах уменьшенной задачи, переводит их следующее решение
+            pool->reduced = true;
+            pool->original = std::move(reduced.original);
+            pool->taken = std::move(reduced.taken);
+        }
+        return solution;
+    }
+
+    // решение уже уменьшенной задачи со своим SolveControl - для составных решателей (portfolio.h), которые решают
+    // одну уменьшенную задачу несколькими решателями с общими сроком и рекордом
+    Solution solve_reduced(const Instance& instance, SolveControl& control) const {
+        return solve_instance(instance, control);
+    }
+
+protected:
+    virtual ParameterStatus set_solver_parameter(const std::string& /* name */, const std::string& /* value */) {
+        return ParameterStatus::unknown;
+    }
+
+    // решение задачи (уже после предобработки); control - срок, отмена и рекорды этого решения
+    virtual Solution solve_instance(const Instance& instance, SolveControl& control) const = 0;
+};
+
+// параметр передается всем решателям; ошибка, если его не знает ни один или значение недопустимо
+inline bool set_parameter(const std::vector<Solver*>& solvers, const std::string& name, const std::string& value) {
+    bool applied = false;
+    for (Solver* solver : solvers) {
+        ParameterStatus status = solver->set_parameter(name, value);
+        if (status == ParameterStatus::invalid) {
+            std::cerr << "Error: invalid value '" << value << "' of parameter '" << name << "'.\n";
+            return false;
+        }
+        applied = applied || status == ParameterStatus::applied;
+    }
+    if (!applied) {
+        std::cerr << "Error: unknown parameter '" << name << "'.\n";
+    }
+    return applied;
+}
+
+// пара "имя=значение" без пробелов по краям
+inline bool set_parameter(const std::vector<Solver*>& solvers, const std::string& assignment) {
+    auto trim = [](const std::string& text) {
+        size_t first = text.find_first_not_of(" \t\r");
+        return first == std::string::npos ? std::string() : text.substr(first, text.find_last_not_of(" \t\r") - first + 1);
+    };
+    size_t separator = assignment.find('=');
+    if (separator == std::string::npos) {
+        std::cerr << "Error: expected 'name=value', got '" << assignment << "'.\n";
+        return false;
+    }
+    return set_parameter(solvers, trim(assignment.substr(0, separator)), trim(assignment.substr(separator + 1)));
+}
+
+// файл настроек: по строке "имя = значение", пустые строки и комментарии после # пропускаются
+inline bool read_config(const std::vector<Solver*>& solvers, const std::string& filename) {
+    std::ifstream file(filename);
+    if (!file.is_open()) {
+        std::cerr << "Error: can't open the file '" << filename << "'.\n";
+        return false;
+    }
+    std::string line;
+    while (std::getline(file, line)) {
+        line = line.substr(0, line.find('#'));
+        if (line.find_first_not_of(" \t\r") != std::string::npos && !set_parameter(solvers, line)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// аргументы вида --config=файл и --имя=значение применяются по порядку, поэтому более поздние переопределяют более ранние
+inline bool parse_arguments(const std::vector<Solver*>& solvers, int argc, char* argv[]) {
+    for (int i = 1; i < argc; ++i) {
+        std::string argument = argv[i];
+        if (argument.rfind("--", 0) != 0) {
+            std::cerr << "Error: unexpected argument '" << argument << "', expected --config=file or --name=value.\n";
+            return false;
+        }
+        argument = argument.substr(2);
+        if (argument.rfind("config=", 0) == 0 ? !read_config(solvers, argument.substr(7)) : !set_parameter(solvers, argument)) {
+            return false;
+        }
+    }
+    for (Solver* solver : solvers) {
+        if (const char* error = solver->check_parameters()) {
+            std::cerr << "Error: " << error << '\n';
+            return false;
+        }
+    }
+    return true;
+}
+
+inline bool manual_input(Instance& instance, bool sort = true) {
+    int n, max_weight;
+    std::cout << "Input number of items: ";
+    std::cin >> n;
+    std::cout << "Input max backpack weight: ";
+    std::cin >> max_weight;
+    if (!std::cin || n < 0) {
+        std::cerr << "Error: expected the number of items and max weight.\n";
+        return false;
+    }
+    std::cout << "Input n pairs: price - weight\n";
+    std::vector<int> prices(n), weights(n);
+    for (int i = 0; i < n; ++i) {
+        std::cin >> prices[i] >> weights[i];
+    }
+    prepare_instance(max_weight, prices.data(), weights.data(), n, instance, sort);
+    return true;
+}
+
+// текстовый или двоичный файл, см. instance_loader.h
+inline bool file_input(const std::string& filename, Instance& instance, bool sort = true) {
+    LoadedInstance loaded;
+    if (!load_instance(filename, loaded)) {
+        return false;
+    }
+    prepare_instance(loaded, instance, sort);
+    return true;
+}
+
+// sort - см. prepare_instance
+inline bool input_data(Instance& instance, bool sort = true) {
+    std::string filename;
+    std::cout << "Enter input filename or press Enter to manually input data: ";
+    std::getline(std::cin, filename);
+    if (filename.empty()) {
+        return manual_input(instance, sort);
+    }
+    return file_input(filename, instance, sort);
+}
+
+inline void print_solution(const Solution& solution, std::chrono::nanoseconds time_spent) {
+    std::cout << "Maximum price that can be taken: " << solution.price << '\n';
+    std::cout << "Items taken (0-based indices):";
+    for (int index : solution.items) {
+        std::cout << ' ' << index;
+    }
+    std::cout << '\n';
+    if (solution.stopped) {
+        std::cout << "The search was stopped early, the answer may be not optimal.\n";
+    }
+    if (solution.price < solution.upper_bound) {
+        std::cout << "Upper bound: " << solution.upper_bound << " (gap " << 100.0 * (solution.upper_bound - solution.price) / solution.upper_bound << "%)\n";
+    }
+    std::cout << "Time spent:\n";
+    std::cout << "t = " << time_spent.count() << " nanoseconds\n";
+    std::cout << "t ~ " << std::chrono::duration_cast<std::chrono::milliseconds>(time_spent).count() << " milliseconds\n";
+    std::cout << "t ~ " << std::chrono::duration_cast<std::chrono::seconds>(time_spent).count() << " seconds\n";
+}
+
+inline std::atomic<bool> interrupted{false};
+
+// Ctrl+C останавливает решение, и выводится лучший найденный ответ; повторный Ctrl+C завершает программу как обычно
+inline void cancel_on_interrupt(Solver& solver) {
+    std::signal(SIGINT, [](int) {
+        interrupted.store(true);
+        std::signal(SIGINT, SIG_DFL);
+    });
+    solver.cancelled = &interrupted;
+}
+
+inline void wait_for_exit() {
+#if defined(NDEBUG)
+    std::cout << "Press Enter to exit...";
+    std::cin.ignore();
+    std::cin.get();
+#endif
+}
+
+/*
+Рабочее пространство потока решения в пакетном режиме: буферы задачи переиспользуются между задачами.
+Потоки OpenMP делятся между потоками решения, иначе при нескольких одновременных задачах ядер было бы занято больше, чем есть.
+*/
+struct SolverWorkspace {
+    Instance instance;
+
+    explicit SolverWorkspace([[maybe_unused]] int workers_count) noexcept {
+#if defined(_OPENMP)
+        omp_set_num_threads(std::max(1, omp_get_max_threads() / workers_count));
+#endif
+    }
+};
+
+// пакетный режим (см. batch_service.h) для одного решателя
+inline int run_batch(const BatchOptions& options, const Solver& solver) {
+    return run_batch<SolverWorkspace>(options, [&](const LoadedInstance& loaded, SolverWorkspace& workspace) {
+        {
+            PhaseTimer phase(solver.instrumentation, Phase::preparation);
+            prepare_instance(loaded, workspace.instance, solver.needs_sorted_items());
+        }
+        return solver.solve(workspace.instance);
+    });
+}
\ No newline at end of file
@@ -2,195 +2,181 @@
 #include <fstream>
 #include <string>
 #include <vector>
-#include <unordered_set>
-#include <algorithm>
 #include <random>
-#include <ctime>
 #include <chrono>
-#include <omp.h>
-
-#define POPULATION_SIZE 800 // размер популяции (число особей определяет разнообразие решений в каждом поколении)
-#define GENERATIONS 100 // число поколений - определяет время жизни популяции, чем больше, тем больше шансов получить хорошее решение
-#define MUTATION_RATE 0.1 // вероятность мутации - мутация позволяет выпрыгнуть из локального экстремума, но мутации не должны быть слишком частыми, чтобы решение сходилось. При частых мутациях решение будет слабо отличаться от случайного
-#define BATTLE_SIZE 18 // число особей, участвующих в "битве" - имитация естественного отбора и борьбы за выживание
-#define TOURNAMENT_SIZE 100 // число особей, участвующих в борьбе за выбор родителя
+#include <atomic>
+#include <cstdlib>
+#include "parallel_genetic.h"
 
 using namespace std;
+using namespace parallel_genetic;
 
-struct Item {
-    int price;
-    int weight;
-};
+#if defined(BENCHMARK)
+atomic<long long> allocations_count(0); // счетчик выделений памяти через new
 
-// особь
-struct Individual {
-    vector<bool> DNA; // ДНК - это какие предметы взяты в рюкзак
-    int fitness; // приспособленность к выживанию - это суммарная стоимость, если вес не превышает максимального, или 0 в противном случае
+void* operator new(size_t size) {
+    allocations_count.fetch_add(1, memory_order_relaxed);
+    if (void* pointer = malloc(size == 0 ? 1 : size)) {
+        return pointer;
+    }
+    throw bad_alloc();
+}
 
-    Individual() noexcept : fitness(0) {}
+void operator delete(void* pointer) noexcept {
+    free(pointer);
+}
 
-    Individual(int max_weight, const vector<Item>& items, const vector<bool>& individual_dna) noexcept :
-        DNA(individual_dna),
-        fitness(0) {
-        int price = 0;
-        int weight = 0;
-        for (int i = 0; i < items.size(); ++i) {
-            if (DNA[i]) {
-                price += items[i].price;
-                weight += items[i].weight;
-            }
-        }
+void operator delete(void* pointer, size_t) noexcept {
+    free(pointer);
+}
 
-        if (weight <= max_weight) {
-            fitness = price;
+// скорость поколений, выделения памяти в цикле поколений, масштабирование модели островов и скорость специализированных версий поколения
+void benchmark() {
+    // цикл поколений (число потоков - OMP_NUM_THREADS): буферы популяции создаются один раз, поэтому выделений памяти в цикле быть не должно
+    constexpr int generations = 10;
+    cout << "n\tgenerations/sec\tallocations in generations loop\n";
+    for (int n : {1000, 10000}) {
+        mt19937 generator(n);
+        uniform_int_distribution<int> distribution(1, 1000);
+        vector<Item> items(n);
+        long long total_weight = 0;
+        for (auto& item : items) {
+            item.price = distribution(generator);
+            item.weight = distribution(generator);
+            total_weight += item.weight;
+        }
+        int max_weight = static_cast<int>(total_weight / 2);
+        Instance instance;
+        prepare_instance(max_weight, items, instance);
+        ItemArrays item_arrays(instance);
+        Parameters parameters;
+        Population population(parameters.population_size, item_arrays.words);
+        Population new_population(parameters.population_size, item_arrays.words);
+        create_random_population(max_weight, item_arrays, population, n);
+        GenerationKernel next_generation_kernel = select_generation_kernel(item_arrays.words, parameters.tournament_size);
+        long long allocations_before = allocations_count.load();
+        auto start = chrono::high_resolution_clock::now();
+        for (int generation = 0; generation < generations; ++generation) {
+            next_generation_kernel(max_weight, item_arrays, parameters, population, new_population, n, generation);
+            swap(population, new_population);
         }
+        double seconds = chrono::duration<double>(chrono::high_resolution_clock::now() - start).count();
+        cout << n << '\t' << generations / seconds << '\t' << allocations_count.load() - allocations_before << '\n';
     }
-};
-
-int solve(int max_weight, const vector<Item>& items) noexcept {
-    vector<Individual> population(POPULATION_SIZE);
-
-#pragma omp parallel
-    {
-        int thread_id = omp_get_thread_num();
-        mt19937 random_generator(random_device{}() + thread_id);
 
-#pragma omp for
-        for (int i = 0; i < POPULATION_SIZE; ++i) {
-            vector<bool> dna(items.size());
-            for (int j = 0; j < items.size(); ++j) {
-                dna[j] = random_generator() & 1;
+    // модель островов: общее население то же (population_size), меняется только число островов; 0 - одна общая популяция
+    constexpr int seeds = 3;
+    cout << "\nn\tislands\tmean price\tgenerations/sec\n";
+    for (int n : {1000, 10000}) {
+        mt19937 generator(n);
+        uniform_int_distribution<int> distribution(1, 1000);
+        vector<Item> items(n);
+        long long total_weight = 0;
+        for (auto& item : items) {
+            item.price = distribution(generator);
+            item.weight = distribution(generator);
+            total_weight += item.weight;
+        }
+        int max_weight = static_cast<int>(total_weight / 2);
+        Instance instance;
+        prepare_instance(max_weight, items, instance);
+        for (int islands_count : {0, 1, 2, 4, 8, 16}) {
+            Parameters parameters;
+            parameters.islands_count = islands_count;
+            long long total_price = 0;
+            auto start = chrono::high_resolution_clock::now();
+            for (uint64_t seed = 1; seed <= seeds; ++seed) {
+                parameters.seed = seed;
+                total_price += (islands_count == 0 ? solve(instance, parameters) : solve_islands(instance, parameters)).price;
             }
-            population[i] = Individual(max_weight, items, dna);
+            double seconds = chrono::duration<double>(chrono::high_resolution_clock::now() - start).count();
+            cout << n << '\t' << islands_count << '\t' << total_price / seeds << '\t' << seeds * parameters.generations / seconds << '\n';
         }
     }
 
-    for (int generation = 0; generation < GENERATIONS; ++generation) {
-        vector<Individual> new_population(POPULATION_SIZE);
-
-#pragma omp parallel
-        {
-            int thread_id = omp_get_thread_num();
-            mt19937 random_generator(random_device{}() + thread_id + generation * 13);
-
-            auto random_index = [&random_generator]() {
-                return random_generator() % POPULATION_SIZE;
-            };
-
-            auto random_double = [&random_generator]() {
-                return uniform_real_distribution<double>(0, 1)(random_generator);
-            };
-
-            auto mutate_dna = [&random_double](vector<bool> dna) {
-                for (int i = 0; i < dna.size(); ++i) {
-                    if (random_double() < MUTATION_RATE) {
-                        dna[i] = !dna[i];
-                    }
-                }
-                return dna;
-            };
-
-            auto tournament_selection = [&random_index , &population]() {
-                Individual best = population[random_index()];
-                for (int i = 1; i < TOURNAMENT_SIZE; ++i) {
-                    Individual challenger = population[random_index()];
-                    if (best.fitness < challenger.fitness) {
-                        best = challenger;
-                    }
-                }
-                return best;
-            };
-
-#pragma omp for
-            for (int i = 0; i < POPULATION_SIZE; i += 2) {
-                Individual mother = tournament_selection();
-                Individual father = tournament_selection();
-
-                vector<bool> son_dna(items.size());
-                vector<bool> daughter_dna(items.size());
-
-                for (int j = 0; j < items.size(); ++j) {
-                    if (random_generator() & 1) {
-                        son_dna[j] = father.DNA[j];
-                        daughter_dna[j] = mother.DNA[j];
-                    } else {
-                        son_dna[j] = mother.DNA[j];
-                        daughter_dna[j] = father.DNA[j];
-                    }
+    // специализированные версии next_generation против общей (число слов и размер турнира известны только при выполнении); зерно одинаковое
+    cout << "\nn\twords\ttournament\tgeneric generations/sec\tspecialized generations/sec\tspeedup\tsame result\n";
+    for (int n : {64, 256, 1024}) {
+        mt19937 generator(n);
+        uniform_int_distribution<int> distribution(1, 1000);
+        vector<Item> items(n);
+        long long total_weight = 0;
+        for (auto& item : items) {
+            item.price = distribution(generator);
+            item.weight = distribution(generator);
+            total_weight += item.weight;
+        }
+        int max_weight = static_cast<int>(total_weight / 2);
+        Instance instance;
+        prepare_instance(max_weight, items, instance);
+        ItemArrays item_arrays(instance);
+        Parameters parameters;
+        auto measure = [&](GenerationKernel kernel, long long& checksum) { // лучшее из 3 запусков, чтобы уменьшить шум
+            double best_speed = 0;
+            for (int run = 0; run < 3; ++run) {
+                Population population(parameters.population_size, item_arrays.words);
+                Population new_population(parameters.population_size, item_arrays.words);
+                create_random_population(max_weight, item_arrays, population, n);
+                auto start = chrono::high_resolution_clock::now();
+                for (int generation = 0; generation < generations * 10; ++generation) {
+                    kernel(max_weight, item_arrays, parameters, population, new_population, n, generation);
+                    swap(population, new_population);
                 }
-
-                new_population[i] = Individual(max_weight, items, mutate_dna(son_dna));
-                if (i + 1 < POPULATION_SIZE) {
-                    new_population[i + 1] = Individual(max_weight, items, mutate_dna(daughter_dna));
+                double seconds = chrono::duration<double>(chrono::high_resolution_clock::now() - start).count();
+                best_speed = max(best_speed, generations * 10 / seconds);
+                checksum = 0;
+                for (long long fitness : population.fitness) {
+                    checksum += fitness;
                 }
             }
-        }
-
-        population = move(new_population);
+            return best_speed;
+        };
+        long long generic_checksum, specialized_checksum;
+        double generic_speed = measure(next_generation<0, 0>, generic_checksum);
+        double specialized_speed = measure(select_generation_kernel(item_arrays.words, parameters.tournament_size), specialized_checksum);
+        cout << n << '\t' << item_arrays.words << '\t' << parameters.tournament_size << '\t' << generic_speed << '\t' << specialized_speed << '\t'
+            << specialized_speed / generic_speed << '\t' << (generic_checksum == specialized_checksum ? "yes" : "no") << '\n';
     }
-
-    int best_price = 0;
-    for (const auto& individual : population) {
-        best_price = max(best_price, individual.fitness);
-    }
-
-    return best_price;
 }
+#endif
 
-vector<Item> manual_input(int& n, int& max_weight) noexcept {
-    cout << "Input number of items: ";
-    cin >> n;
-    cout << "Input max backpack weight: ";
-    cin >> max_weight;
-    cout << "Input n pairs: price - weight\n";
-    vector<Item> items(n);
-    for (int i = 0; i < n; ++i) {
-        cin >> items[i].price >> items[i].weight;
+// Аргументы командной строки: --config=файл и --имя=значение (например, --islands_count=4 --seed=42), см. Parameters
+int main(int argc, char* argv[]) {
+#if defined(BENCHMARK)
+    benchmark();
+    return 0;
+#endif
+    ParallelGeneticSolver solver;
+    solver.parameters.seed = (random_device())();
+    BatchOptions batch;
+    StatisticsOptions statistics;
+    if (!parse_batch_arguments(argc, argv, batch) || !parse_statistics_arguments(argc, argv, statistics) || !parse_arguments({&solver}, argc, argv)) {
+        return 1;
     }
-    return items;
-}
-
-vector<Item> file_input(int& n, int& max_weight, const string& filename) {
-    ifstream file(filename);
-    if (!file.is_open()) {
-        cerr << "Error: can't open the file '" << filename << "'.\n";
-        return {};
+    Instrumentation instrumentation;
+    StatisticsReporter reporter(instrumentation, statistics); // выводит статистику, только если она запрошена
+    if (statistics.enabled) {
+        solver.instrumentation = &instrumentation;
     }
-
-    file >> n >> max_weight;
-    vector<Item> items(n);
-    for (int i = 0; i < n; ++i) {
-        file >> items[i].price >> items[i].weight;
+    if (batch.source != BatchSource::none) {
+        cerr << "Seed: " << solver.parameters.seed << '\n'; // все задачи решаются с одним зерном: ответ не зависит от порядка и потока решения
+        return run_batch(batch, solver);
     }
-    return items;
-}
-
-vector<Item> input_data(int& n, int& max_weight) {
-    string filename;
-    cout << "Enter input filename or press Enter to manually input data: ";
-    getline(cin, filename);
-    if (filename.empty()) {
-        return manual_input(n, max_weight);
+    Instance instance;
+    if (!input_data(instance)) {
+        return 1;
     }
-    return file_input(n, max_weight, filename);
-}
-
-int main() {
-    int n, max_weight;
-    vector<Item> items = input_data(n, max_weight);
+    cancel_on_interrupt(solver);
     auto start = chrono::high_resolution_clock::now();
-    int best_price = solve(max_weight, items);
+    ReductionStatistics reduction;
+    Solution solution = solver.solve(instance, &reduction);
     auto end = chrono::high_resolution_clock::now();
-    auto time_spent = end - start;
-    cout << "Maximum price that can be taken: " << best_price << '\n';
-    cout << "Time spent:\n";
-    cout << "t = " << time_spent.count() << " nanoseconds\n";
-    cout << "t ~ " << chrono::duration_cast<chrono::milliseconds>(time_spent).count() << " milliseconds\n";
-    cout << "t ~ " << chrono::duration_cast<chrono::seconds>(time_spent).count() << " seconds\n";
-#if defined(NDEBUG)
-    std::cout << "Press Enter to exit...";
-    std::cin.ignore();
-    std::cin.get();
-#endif
+    reporter.stop();
+    cout << "Seed: " << solver.parameters.seed << '\n';
+    if (solver.reduction) {
+        print_reduction(reduction);
+    }
+    print_solution(solution, end - start);
+    wait_for_exit();
     return 0;
 }
\ No newline at end of file
@@ -0,0 +1,401 @@
+#pragma once
+
+#include <vector>
+#include <algorithm>
+#include <memory>
+#include <atomic>
+#include <cstdint>
+#include "knapsack.h"
+#include "genetic_common.h"
+
+#if !defined(ISLANDS_COUNT)
+#define ISLANDS_COUNT 0 // число островов (подпопуляций в своих потоках); 0 - одна общая популяция
+#endif
+#define MIGRATION_INTERVAL 10 // через сколько поколений острова обмениваются лучшими особями
+#define MIGRANTS_COUNT 4 // сколько лучших особей остров отправляет соседу за один обмен
+#define MIGRATION_QUEUE_SIZE 16 // вместимость очереди мигрантов острова
+
+namespace parallel_genetic {
+
+using namespace genetic_common;
+
+/*
+Зерно для независимого потока случайных чисел с номером stream. Генератор создается на каждую пару потомков
+(поток = номер поколения и номер пары), поэтому результат зависит только от зерна и не зависит от числа потоков OpenMP
+и от того, какой поток какую пару обработал.
+*/
+inline uint64_t stream_seed(uint64_t seed, uint64_t stream) noexcept {
+    return splitmix64(seed ^ splitmix64(stream));
+}
+
+// параметры алгоритма: по умолчанию берутся из макросов, меняются из командной строки и файла настроек без перекомпиляции
+struct Parameters {
+    int population_size = POPULATION_SIZE;
+    int generations = GENERATIONS;
+    double mutation_rate = MUTATION_RATE;
+    int tournament_size = TOURNAMENT_SIZE;
+    int islands_count = ISLANDS_COUNT;
+    int migration_interval = MIGRATION_INTERVAL;
+    int migrants_count = MIGRANTS_COUNT;
+    int stagnation_generations = STAGNATION_GENERATIONS;
+    uint64_t seed = 0; // зерно генератора: при одинаковом зерне результат одинаковый при любом числе потоков (кроме модели островов)
+};
+
+// новое поколение записывается в new_population; выделений памяти нет
+template<int Words = 0, int TournamentSize = 0>
+void next_generation(int max_weight, const ItemArrays& items, const Parameters& parameters, const Population& population, Population& new_population, uint64_t seed, int generation) noexcept {
+    const int words = Words > 0 ? Words : items.words;
+#pragma omp parallel for
+    for (int i = 0; i < new_population.size; i += 2) {
+        RandomGenerator generator(stream_seed(seed, (static_cast<uint64_t>(generation) + 1) * new_population.size + i));
+        const uint64_t* mother_dna = population.dna(tournament_selection<TournamentSize>(population, parameters.tournament_size, generator));
+        const uint64_t* father_dna = population.dna(tournament_selection<TournamentSize>(population, parameters.tournament_size, generator));
+
+        bool has_daughter = i + 1 < new_population.size;
+        uint64_t* son_dna = new_population.dna(i);
+        uint64_t* daughter_dna = has_daughter ? new_population.dna(i + 1) : nullptr;
+
+        for (int w = 0; w < words; ++w) { // равномерное скрещивание по случайной маске
+            uint64_t from_father = random_word(generator);
+            son_dna[w] = (father_dna[w] & from_father) | (mother_dna[w] & ~from_father);
+            if (has_daughter) {
+                daughter_dna[w] = (mother_dna[w] & from_father) | (father_dna[w] & ~from_father);
+            }
+        }
+
+        mutate_dna(son_dna, items.size, parameters.mutation_rate, generator);
+        new_population.update_fitness<Words>(i, max_weight, items);
+        if (has_daughter) {
+            mutate_dna(daughter_dna, items.size, parameters.mutation_rate, generator);
+            new_population.update_fitness<Words>(i + 1, max_weight, items);
+        }
+    }
+}
+
+using GenerationKernel = void (*)(int, const ItemArrays&, const Parameters&, const Population&, Population&, uint64_t, int) noexcept;
+
+// next_generation как параметр шаблона genetic_common::select_generation_kernel
+template<int Words, int TournamentSize>
+struct NextGeneration {
+    static constexpr GenerationKernel kernel = next_generation<Words, TournamentSize>;
+};
+
+// см. genetic_common::select_generation_kernel
+inline GenerationKernel select_generation_kernel(int words, int tournament_size) noexcept {
+    return genetic_common::select_generation_kernel<NextGeneration>(words, tournament_size);
+}
+
+// случайные особи; поток случайных чисел у каждой свой, как и в next_generation
+inline void create_random_population(int max_weight, const ItemArrays& items, Population& population, uint64_t seed) noexcept {
+#pragma omp parallel for
+    for (int i = 0; i < population.size; ++i) {
+        RandomGenerator generator(stream_seed(seed, i));
+        uint64_t* dna = population.dna(i);
+        for (int w = 0; w < items.words; ++w) {
+            dna[w] = random_word(generator);
+        }
+        dna[items.words - 1] &= items.last_word_mask;
+        population.update_fitness(i, max_weight, items);
+    }
+}
+
+/*
+Рекорд других решателей той же задачи (SolveControl::shared, см. portfolio.h) заменяет худшую особь популяции, как мигрант.
+Решение копируется, только если версия общего рекорда сменилась с прошлой проверки (seen_version) и он лучше
+best_fitness - лучшей особи, которую популяция уже видела (в том числе своего же рекорда, переданного в общий).
+*/
+inline void import_shared(int max_weight, const ItemArrays& items, Population& population, const SolveControl& control, long long best_fitness,
+    long long& seen_version) {
+    const SharedIncumbent* shared = control.shared();
+    if (shared == nullptr || shared->version() == seen_version) {
+        return;
+    }
+    seen_version = shared->version();
+    if (shared->price() <= best_fitness) {
+        return;
+    }
+    Solution best = shared->best();
+    int worst = static_cast<int>(std::min_element(population.fitness.begin(), population.fitness.end()) - population.fitness.begin());
+    if (best.price <= population.fitness[worst]) {
+        return;
+    }
+    uint64_t* dna = population.dna(worst);
+    std::fill(dna, dna + population.words, 0);
+    for (int item : best.items) {
+        dna[item / WORD_BITS] |= 1ull << (item % WORD_BITS);
+    }
+    population.update_fitness(worst, max_weight, items);
+}
+
+// instrumentation - если не nullptr, сюда пишутся счетчики поколений (см. instrumentation.h)
+// control - срок, отмена и обратный вызов для рекордов; проверяется после каждого поколения
+inline Solution solve(const Instance& instance, const Parameters& parameters, Instrumentation* instrumentation = nullptr, SolveControl* control = nullptr) noexcept {
+    if (instance.count == 0) {
+        return {0, {}};
+    }
+    PhaseTimer phase(instrumentation, Phase::initialization);
+    ThreadProbe probe(instrumentation);
+    const int max_weight = instance.max_weight;
+    ItemArrays item_arrays(instance);
+    Population population(parameters.population_size, item_arrays.words);
+    Population new_population(parameters.population_size, item_arrays.words); // второй буфер: поколения пишутся в него и меняются местами с population
+    create_random_population(max_weight, item_arrays, population, parameters.seed);
+    if (control != nullptr) {
+        seed_population(max_weight, item_arrays, population, control->seeds());
+    }
+
+    GenerationKernel next_generation_kernel = select_generation_kernel(item_arrays.words, parameters.tournament_size);
+    BestIndividual best(item_arrays.words);
+    best.update(population, item_arrays, control);
+    bool stopped = false;
+    long long shared_version = 0;
+    phase.next(Phase::search);
+    for (int generation = 0, stagnation = 0; generation < parameters.generations; ++generation) {
+        next_generation_kernel(max_weight, item_arrays, parameters, population, new_population, parameters.seed, generation);
+        std::swap(population, new_population);
+        if (control != nullptr) {
+            import_shared(max_weight, item_arrays, population, *control, best.fitness, shared_version);
+        }
+        probe.generation(population.fitness);
+        if (best.update(population, item_arrays, control)) {
+            stagnation = 0;
+        } else if (0 < parameters.stagnation_generations && parameters.stagnation_generations <= ++stagnation) {
+            break; // лучшая особь давно не улучшается
+        }
+        if (control != nullptr && control->stop_requested()) {
+            stopped = generation + 1 < parameters.generations;
+            break;
+        }
+    }
+
+    phase.next(Phase::reconstruction);
+    if (control != nullptr && control->collects_pool()) {
+        export_population(population, item_arrays, *control);
+    }
+    Solution solution = best.solution(item_arrays);
+    solution.stopped = stopped;
+    return solution;
+}
+
+/*
+Очередь мигрантов без блокировок: кольцевой буфер на одного писателя (соседний остров) и одного читателя (остров-владелец).
+Писатель двигает tail, читатель - head; они лежат в разных кеш-линиях, чтобы острова не мешали друг другу.
+Если очередь полна, мигрант отбрасывается - остров никогда не ждет соседа.
+*/
+struct MigrationQueue {
+    int capacity; // число мест для мигрантов
+    int words; // число слов ДНК одной особи
+    std::vector<uint64_t> DNA;
+    std::vector<long long> fitness;
+    alignas(64) std::atomic<size_t> head{0}; // следующий мигрант для чтения
+    alignas(64) std::atomic<size_t> tail{0}; // следующее свободное место для записи
+
+    MigrationQueue(int queue_capacity, int dna_words) noexcept :
+        capacity(queue_capacity),
+        words(dna_words),
+        DNA(static_cast<size_t>(queue_capacity) * dna_words, 0),
+        fitness(queue_capacity, 0) {}
+
+    bool push(const uint64_t* dna, long long dna_fitness) noexcept {
+        size_t position = tail.load(std::memory_order_relaxed);
+        if (position - head.load(std::memory_order_acquire) == static_cast<size_t>(capacity)) {
+            return false;
+        }
+        int slot = static_cast<int>(position % capacity);
+        std::copy(dna, dna + words, DNA.data() + static_cast<size_t>(slot) * words);
+        fitness[slot] = dna_fitness;
+        tail.store(position + 1, std::memory_order_release);
+        return true;
+    }
+
+    // следующий мигрант заменяет особь dna с приспособленностью dna_fitness, только если он лучше нее, иначе отбрасывается;
+    // false - очередь пуста
+    bool pop(uint64_t* dna, long long& dna_fitness) noexcept {
+        size_t position = head.load(std::memory_order_relaxed);
+        if (position == tail.load(std::memory_order_acquire)) {
+            return false;
+        }
+        int slot = static_cast<int>(position % capacity);
+        if (dna_fitness < fitness[slot]) {
+            const uint64_t* source = DNA.data() + static_cast<size_t>(slot) * words;
+            std::copy(source, source + words, dna);
+            dna_fitness = fitness[slot];
+        }
+        head.store(position + 1, std::memory_order_release);
+        return true;
+    }
+};
+
+// остров: своя подпопуляция (два буфера поколений), лучшая особь острова, входящая очередь мигрантов и буфер индексов отправляемых особей
+struct Island {
+    Population population;
+    Population new_population;
+    BestIndividual best;
+    MigrationQueue inbox;
+    std::vector<int> migrants;
+    bool stopped = false; // остров остановлен по сроку или отмене раньше последнего поколения
+
+    Island(int population_size, int dna_words, int migrants_count) noexcept :
+        population(population_size, dna_words),
+        new_population(population_size, dna_words),
+        best(dna_words),
+        inbox(std::max(MIGRATION_QUEUE_SIZE, 2 * migrants_count), dna_words),
+        migrants(migrants_count) {}
+};
+
+// лучшие migrants.size() особей острова отправляются соседу
+inline void send_migrants(const Population& population, std::vector<int>& migrants, MigrationQueue& neighbour) noexcept {
+    const int capacity = static_cast<int>(migrants.size());
+    int* best = migrants.data();
+    int count = 0;
+    for (int i = 0; i < population.size; ++i) { // вставками держим capacity лучших по убыванию
+        int position = count < capacity ? count++ : capacity;
+        while (0 < position && population.fitness[best[position - 1]] < population.fitness[i]) {
+            if (position < capacity) {
+                best[position] = best[position - 1];
+            }
+            --position;
+        }
+        if (position < capacity) {
+            best[position] = i;
+        }
+    }
+    for (int i = 0; i < count; ++i) {
+        neighbour.push(population.dna(best[i]), population.fitness[best[i]]);
+    }
+}
+
+// прибывшие мигранты заменяют худших особей острова, если они лучше их
+inline void receive_migrants(Population& population, MigrationQueue& inbox) noexcept {
+    while (true) {
+        int worst = static_cast<int>(std::min_element(population.fitness.begin(), population.fitness.end()) - population.fitness.begin());
+        if (!inbox.pop(population.dna(worst), population.fitness[worst])) {
+            return;
+        }
+    }
+}
+
+/*
+Модель островов: население population_size делится на islands_count подпопуляций, каждую развивает свой поток.
+Память острова выделяется и заполняется его потоком (при OMP_PROC_BIND страницы окажутся в локальном узле NUMA),
+турнирный отбор идет только внутри острова, общих барьеров между поколениями нет.
+Каждые migration_interval поколений остров отправляет лучших особей следующему острову по кольцу.
+Время прихода мигрантов зависит от планирования потоков, поэтому при islands_count > 1 результат при одном зерне может меняться.
+*/
+inline Solution solve_islands(const Instance& instance, const Parameters& parameters, Instrumentation* instrumentation = nullptr, SolveControl* control = nullptr) noexcept {
+    if (instance.count == 0) {
+        return {0, {}};
+    }
+    PhaseTimer phase(instrumentation, Phase::initialization);
+    const int max_weight = instance.max_weight;
+    const int islands_count = parameters.islands_count;
+    ItemArrays item_arrays(instance);
+    int island_size = std::max(2, parameters.population_size / islands_count);
+    GenerationKernel next_generation_kernel = select_generation_kernel(item_arrays.words, parameters.tournament_size);
+    std::vector<std::unique_ptr<Island>> islands(islands_count);
+
+#pragma omp parallel for schedule(static, 1) num_threads(islands_count)
+    for (int i = 0; i < islands_count; ++i) {
+        islands[i] = std::make_unique<Island>(island_size, item_arrays.words, parameters.migrants_count);
+    }
+
+    phase.next(Phase::search); // начальные популяции создаются потоками островов и считаются поиском
+#pragma omp parallel for schedule(static, 1) num_threads(islands_count)
+    for (int i = 0; i < islands_count; ++i) {
+        Island& island = *islands[i];
+        ThreadProbe probe(instrumentation);
+        MigrationQueue& neighbour = islands[(i + 1) % islands_count]->inbox;
+        uint64_t island_seed = stream_seed(parameters.seed, ~static_cast<uint64_t>(i)); // потоки островов не пересекаются с потоками пар
+        create_random_population(max_weight, item_arrays, island.population, island_seed);
+        if (control != nullptr) {
+            seed_population(max_weight, item_arrays, island.population, control->seeds(), i, islands_count); // решения теплого старта делятся между островами
+        }
+        island.best.update(island.population, item_arrays, control);
+        long long shared_version = 0;
+        for (int generation = 0, stagnation = 0; generation < parameters.generations; ++generation) {
+            next_generation_kernel(max_weight, item_arrays, parameters, island.population, island.new_population, island_seed, generation); // вложенный parallel for выполняется этим же потоком
+            std::swap(island.population, island.new_population);
+            if (1 < islands_count && (generation + 1) % parameters.migration_interval == 0) {
+                send_migrants(island.population, island.migrants, neighbour);
+                receive_migrants(island.population, island.inbox);
+            }
+            if (control != nullptr) {
+                import_shared(max_weight, item_arrays, island.population, *control, island.best.fitness, shared_version);
+            }
+            probe.generation(island.population.fitness, i);
+            if (island.best.update(island.population, item_arrays, control)) {
+                stagnation = 0;
+            } else if (0 < parameters.stagnation_generations && parameters.stagnation_generations <= ++stagnation) {
+                break; // остров давно не улучшается, соседи продолжают без его мигрантов
+            }
+            if (control != nullptr && control->stop_requested()) {
+                island.stopped = generation + 1 < parameters.generations;
+                break;
+            }
+        }
+    }
+
+    phase.next(Phase::reconstruction);
+    int best_island = 0;
+    bool stopped = false;
+    for (int i = 0; i < islands_count; ++i) {
+        if (islands[best_island]->best.fitness < islands[i]->best.fitness) {
+            best_island = i;
+        }
+        stopped = stopped || islands[i]->stopped;
+        if (control != nullptr && control->collects_pool()) {
+            export_population(islands[i]->population, item_arrays, *control);
+        }
+    }
+    Solution solution = islands[best_island]->best.solution(item_arrays);
+    solution.stopped = stopped;
+    return solution;
+}
+
+// один параметр по имени
+inline ParameterStatus set_parameter(Parameters& parameters, const std::string& name, const std::string& value) noexcept {
+    bool parsed;
+    if (name == "population_size") {
+        parsed = parse_number(value, parameters.population_size) && 0 < parameters.population_size;
+    } else if (name == "generations") {
+        parsed = parse_number(value, parameters.generations) && 0 <= parameters.generations;
+    } else if (name == "mutation_rate") {
+        parsed = parse_number(value, parameters.mutation_rate) && 0 <= parameters.mutation_rate && parameters.mutation_rate <= 1;
+    } else if (name == "tournament_size") {
+        parsed = parse_number(value, parameters.tournament_size) && 0 < parameters.tournament_size;
+    } else if (name == "islands_count") {
+        parsed = parse_number(value, parameters.islands_count) && 0 <= parameters.islands_count;
+    } else if (name == "migration_interval") {
+        parsed = parse_number(value, parameters.migration_interval) && 0 < parameters.migration_interval;
+    } else if (name == "migrants_count") {
+        parsed = parse_number(value, parameters.migrants_count) && 0 < parameters.migrants_count;
+    } else if (name == "stagnation_generations") {
+        parsed = parse_number(value, parameters.stagnation_generations) && 0 <= parameters.stagnation_generations;
+    } else if (name == "seed") {
+        parsed = parse_number(value, parameters.seed);
+    } else {
+        return ParameterStatus::unknown;
+    }
+    return parsed ? ParameterStatus::applied : ParameterStatus::invalid;
+}
+
+class ParallelGeneticSolver : public Solver {
+public:
+    Parameters parameters;
+
+    const char* name() const noexcept override {
+        return "parallel_genetic";
+    }
+
+protected:
+    Solution solve_instance(const Instance& instance, SolveControl& control) const override {
+        return parameters.islands_count > 0 ? solve_islands(instance, parameters, instrumentation, &control)
+            : parallel_genetic::solve(instance, parameters, instrumentation, &control);
+    }
+
+    ParameterStatus set_solver_parameter(const std::string& name, const std::string& value) override {
+        return parallel_genetic::set_parameter(parameters, name, value);
+    }
+};
+
+}
\ No newline at end of file
@@ -0,0 +1,135 @@
+#include <iostream>
+#include <string>
+#include <vector>
+#include <memory>
+#include <algorithm>
+#include <random>
+#include <chrono>
+#include <mutex>
+#include "portfolio.h"
+#if defined(BENCHMARK)
+#include "instance_generators.h"
+#endif
+
+using namespace std;
+using namespace portfolio;
+
+#if defined(BENCHMARK)
+// время до каждого рекорда: когда решатель впервые нашел ответ не хуже target и когда нашел свой лучший
+struct IncumbentTimes {
+    mutex lock;
+    chrono::steady_clock::time_point start = chrono::steady_clock::now();
+    long long best_price = -1;
+    double best_seconds = -1;
+    vector<pair<double, long long>> records; // (секунды, цена)
+
+    void add(const Solution& solution) {
+        lock_guard<mutex> guard(lock);
+        double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+        records.push_back({seconds, solution.price});
+        if (best_price < solution.price) {
+            best_price = solution.price;
+            best_seconds = seconds;
+        }
+    }
+
+    double seconds_to(long long target) const noexcept {
+        for (auto [seconds, price] : records) {
+            if (target <= price) {
+                return seconds;
+            }
+        }
+        return -1;
+    }
+};
+
+// на каждом семействе задач: время до ответа не хуже 99,9% лучшего известного, до лучшего ответа и до конца решения
+// у метода ветвей и границ и ГА по отдельности (с тем же числом потоков, что у них в портфеле) и у портфеля
+void benchmark() {
+    constexpr int time_limit = 5000;
+    PortfolioSolver portfolio_solver;
+    portfolio_solver.set_parameter("seed", "1");
+    branch_bound::BranchAndBoundSolver branch_bound_solver = portfolio_solver.branch_bound;
+    branch_bound_solver.options.warm_start = true;
+    parallel_genetic::ParallelGeneticSolver genetic_solver = portfolio_solver.genetic;
+    vector<Solver*> solvers{&branch_bound_solver, &genetic_solver, &portfolio_solver};
+    for (Solver* solver : solvers) {
+        solver->time_limit = chrono::milliseconds(time_limit);
+    }
+
+    cout << "time limit " << time_limit << " ms, branch_bound threads " << portfolio_solver.branch_bound.threads_count
+        << ", genetic islands " << portfolio_solver.genetic.parameters.islands_count << '\n';
+    cout << "instance\tn\tsolver\tprice\tproven\tms to 99.9%\tms to best\tmilliseconds\n";
+    for (InstanceFamily family : INSTANCE_FAMILIES) {
+        for (int n : {1000, 10000}) {
+            Instance instance;
+            generate_instance(family, n, 1000, 0.5, n, instance);
+            vector<Solution> solutions;
+            vector<unique_ptr<IncumbentTimes>> times;
+            vector<double> milliseconds;
+            for (Solver* solver : solvers) {
+                times.push_back(make_unique<IncumbentTimes>());
+                IncumbentTimes& solver_times = *times.back();
+                solver->on_incumbent = [&](const Solution& solution) { solver_times.add(solution); };
+                solutions.push_back(solver->solve(instance));
+                solver_times.add(solutions.back());
+                milliseconds.push_back(chrono::duration<double, milli>(chrono::steady_clock::now() - solver_times.start).count());
+                solver->on_incumbent = nullptr;
+            }
+            long long best_price = 0;
+            for (const Solution& solution : solutions) {
+                best_price = max(best_price, solution.price);
+            }
+            for (size_t i = 0; i < solvers.size(); ++i) {
+                cout << family_name(family) << '\t' << n << '\t' << solvers[i]->name() << '\t' << solutions[i].price << '\t'
+                    << (solutions[i].upper_bound == solutions[i].price ? "yes" : "no") << '\t'
+                    << times[i]->seconds_to(static_cast<long long>(best_price * 0.999)) * 1000 << '\t' << times[i]->best_seconds * 1000 << '\t'
+                    << milliseconds[i] << '\n';
+            }
+        }
+    }
+}
+#endif
+
+// Аргументы командной строки: --config=файл и --имя=значение - параметры метода ветвей и границ и ГА
+// (например, --portfolio_threads=8 --seed=42), --time_limit=мс - срок решения, по истечении выводится общий рекорд
+int main(int argc, char* argv[]) {
+#if defined(BENCHMARK)
+    benchmark();
+    return 0;
+#endif
+    PortfolioSolver solver;
+    solver.genetic.parameters.seed = (random_device())();
+    BatchOptions batch;
+    StatisticsOptions statistics;
+    if (!parse_batch_arguments(argc, argv, batch) || !parse_statistics_arguments(argc, argv, statistics) || !parse_arguments({&solver}, argc, argv)) {
+        return 1;
+    }
+    Instrumentation instrumentation;
+    StatisticsReporter reporter(instrumentation, statistics); // выводит статистику, только если она запрошена
+    if (statistics.enabled) {
+        solver.instrumentation = &instrumentation;
+    }
+    if (batch.source != BatchSource::none) {
+        solver.share_threads(batch_workers_count(batch)); // потоки портфеля (PORTFOLIO_THREADS или заданные аргументами) делятся между потоками решения
+        cerr << "Seed: " << solver.genetic.parameters.seed << '\n';
+        return run_batch(batch, solver);
+    }
+    Instance instance;
+    if (!input_data(instance)) {
+        return 1;
+    }
+    cancel_on_interrupt(solver);
+    auto start = chrono::high_resolution_clock::now();
+    ReductionStatistics reduction;
+    Solution solution = solver.solve(instance, &reduction);
+    auto end = chrono::high_resolution_clock::now();
+    reporter.stop();
+    cout << "Seed: " << solver.genetic.parameters.seed << '\n';
+    if (solver.reduction) {
+        print_reduction(reduction);
+    }
+    print_solution(solution, end - start);
+    wait_for_exit();
+    return 0;
+}
\ No newline at end of file
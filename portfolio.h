@@ -0,0 +1,152 @@
+#pragma once
+
+/*
+Портфель решателей: заранее неизвестно, что быстрее даст хороший ответ на данной задаче - метод ветвей и границ,
+ГА или жадный алгоритм, поэтому они решают одну и ту же уже подготовленную и уменьшенную задачу одновременно.
+- Жадный ответ с локальным поиском (greedy::local_search_solve) считается первым: он почти ничего не стоит и сразу
+  становится начальным рекордом обоих решателей (теплый старт через SolveControl::seeds) и первым общим рекордом.
+- Метод ветвей и границ и параллельный ГА работают в своих потоках, ядра делятся между ними (set_threads).
+- Рекорды общие (SharedIncumbent): решение ГА поднимает рекорд, по которому метод ветвей и границ отсекает состояния,
+  а рекорд метода ветвей и границ заменяет худшую особь популяции ГА.
+- Решение заканчивается, когда метод ветвей и границ доказал оптимальность общего рекорда (тогда ГА останавливается),
+  по сроку или по отмене. Ответ - общий рекорд, верхняя оценка - оценка метода ветвей и границ.
+*/
+
+#include <vector>
+#include <string>
+#include <atomic>
+#include <thread>
+#include <algorithm>
+#include "knapsack.h"
+#include "greedy.h"
+#include "branch_bound.h"
+#include "parallel_genetic.h"
+
+#if !defined(PORTFOLIO_THREADS)
+#define PORTFOLIO_THREADS 0 // число потоков портфеля; 0 - std::thread::hardware_concurrency()
+#endif
+
+namespace portfolio {
+
+class PortfolioSolver : public Solver {
+public:
+    branch_bound::BranchAndBoundSolver branch_bound;
+    parallel_genetic::ParallelGeneticSolver genetic;
+
+    PortfolioSolver() noexcept {
+        branch_bound.options.warm_start = false; // начальный рекорд приходит от портфеля
+        set_threads(PORTFOLIO_THREADS);
+    }
+
+    const char* name() const noexcept override {
+        return "portfolio";
+    }
+
+    // делит потоки между решателями: половина - потокам поиска метода ветвей и границ, остальные - островам ГА (хотя бы по одному)
+    void set_threads(int threads_count) noexcept {
+        if (threads_count <= 0) {
+            threads_count = static_cast<int>(std::thread::hardware_concurrency());
+        }
+        threads_count = std::max(threads_count, 2);
+        branch_bound.threads_count = threads_count / 2;
+        genetic.parameters.islands_count = threads_count - branch_bound.threads_count;
+    }
+
+    // делит уже заданные потоки решателей (set_threads, threads_count, islands_count) между workers_count потоками
+    // решения пакетного режима; каждому решателю остается хотя бы один поток, islands_count = 0 (ГА без островов) не меняется
+    void share_threads(int workers_count) noexcept {
+        branch_bound.threads_count = std::max(1, branch_bound.threads_count / workers_count);
+        if (genetic.parameters.islands_count > 0) {
+            genetic.parameters.islands_count = std::max(1, genetic.parameters.islands_count / workers_count);
+        }
+    }
+
+protected:
+    Solution solve_instance(const Instance& instance, SolveControl& control) const override {
+        SharedIncumbent shared;
+        Solution start = greedy::local_search_solve(instance);
+        for (const std::vector<int>& seed : control.seeds()) { // теплый старт портфеля - тоже кандидат в начальный рекорд
+            long long price = 0;
+            for (int item : seed) {
+                price += instance.prices[item];
+            }
+            if (start.price < price) {
+                start = {price, seed};
+            }
+        }
+        shared.offer(start);
+        control.publish(start);
+
+        std::atomic<bool> proven(false); // метод ветвей и границ доказал оптимальность общего рекорда
+        IncumbentCallback share = [&](const Solution& solution) {
+            if (shared.offer(solution)) {
+                control.publish(solution);
+            }
+        };
+        SolveControl branch_bound_control(std::chrono::milliseconds(0), nullptr, share);
+        SolveControl genetic_control(std::chrono::milliseconds(0), &proven, share);
+        std::vector<std::vector<int>> seeds{start.items};
+        seeds.insert(seeds.end(), control.seeds().begin(), control.seeds().end());
+        for (SolveControl* member : {&branch_bound_control, &genetic_control}) {
+            member->set_parent(&control);
+            member->set_shared(&shared);
+            member->set_seeds(seeds);
+        }
+        std::vector<std::vector<int>> genetic_pool; // последнее поколение ГА - пул портфеля для следующего теплого старта
+        if (control.collects_pool()) {
+            genetic_control.set_pool(&genetic_pool);
+        }
+
+        // решатели портфеля пишут счетчики туда же, куда и сам портфель; копии - потому что решатель при решении не меняется
+        branch_bound::BranchAndBoundSolver bound_solver = branch_bound;
+        parallel_genetic::ParallelGeneticSolver genetic_solver = genetic;
+        bound_solver.instrumentation = genetic_solver.instrumentation = instrumentation;
+
+        Solution genetic_solution;
+        std::thread genetic_thread([&] {
+            genetic_solution = genetic_solver.solve_reduced(instance, genetic_control);
+        });
+        Solution bound_solution = bound_solver.solve_reduced(instance, branch_bound_control);
+        if (bound_solution.upper_bound <= shared.price()) {
+            proven.store(true);
+        }
+        genetic_thread.join();
+        share(bound_solution); // рекорды без обратного вызова (например, жадный ответ после остановки) тоже учитываются
+        share(genetic_solution);
+
+        Solution solution = shared.best();
+        solution.upper_bound = std::max(bound_solution.upper_bound, solution.price);
+        solution.stopped = solution.price < solution.upper_bound;
+        for (std::vector<int>& items : genetic_pool) {
+            control.add_to_pool(std::move(items));
+        }
+        return solution;
+    }
+
+    // portfolio_threads - см. set_threads; остальные параметры передаются обоим решателям (threads_count - методу ветвей
+    // и границ, islands_count - ГА), поэтому после portfolio_threads они меняют и деление потоков
+    ParameterStatus set_solver_parameter(const std::string& name, const std::string& value) override {
+        if (name == "portfolio_threads") {
+            int threads_count;
+            bool parsed = parse_number(value, threads_count) && 0 <= threads_count;
+            if (parsed) {
+                set_threads(threads_count);
+            }
+            return parsed ? ParameterStatus::applied : ParameterStatus::invalid;
+        }
+        ParameterStatus status = ParameterStatus::unknown;
+        Solver* members[] = {&branch_bound, &genetic};
+        for (Solver* member : members) {
+            ParameterStatus member_status = member->set_parameter(name, value);
+            if (member_status == ParameterStatus::invalid) {
+                return member_status;
+            }
+            if (member_status == ParameterStatus::applied) {
+                status = member_status;
+            }
+        }
+        return status;
+    }
+};
+
+}
\ No newline at end of file
@@ -0,0 +1,130 @@
+#pragma once
+
+/*
+Сессия решателя для медленно меняющейся задачи: между решениями меняются стоимости и веса нескольких предметов.
+- update(item, price, weight) меняет задачу на месте: предмет переезжает на новое место в порядке по удельной стоимости
+  (бинпоиск и сдвиг O(расстояния) вместо сортировки O(n log n)), остальная подготовка задачи не повторяется;
+- resolve() передает решателю прошлый ответ и пул его последних решений (у ГА - последнее поколение) как теплый старт
+  (Solver::solve, seeds и pool): они чинятся под изменившуюся задачу и становятся начальным рекордом метода ветвей и границ
+  и частью начальной популяции ГА;
+- если ни одно изменение с прошлого решения не могло улучшить никакой набор предметов (стоимость не выросла, вес
+  не уменьшился), прошлая верхняя оценка остается верной. Тогда прошлый ответ, если он по-прежнему помещается и
+  достигает этой оценки, оптимален - и решатель не вызывается вовсе.
+Решатель и его параметры сессия не меняет; один решатель может обслуживать несколько сессий.
+*/
+
+#include <vector>
+#include <algorithm>
+#include "knapsack.h"
+
+class SolverSession {
+public:
+    SolverSession(const Solver& solver, Instance instance) :
+        solver_(solver),
+        instance_(std::move(instance)) {
+        if (!instance_.sorted) {
+            sort_instance(instance_);
+        }
+        positions_.resize(instance_.count);
+        for (int i = 0; i < instance_.count; ++i) {
+            positions_[instance_.order[i]] = i;
+        }
+    }
+
+    // новые стоимость и вес предмета; false - нет такого предмета или вес не положителен
+    bool update(int item, int price, int weight) {
+        if (item < 0 || instance_.count <= item || weight <= 0) {
+            return false;
+        }
+        if (instance_.prices[item] < price || weight < instance_.weights[item]) {
+            bound_valid_ = false; // какой-то набор предметов мог стать лучше прошлого оптимума
+        }
+        instance_.prices[item] = price;
+        instance_.weights[item] = weight;
+        instance_.specific_prices[item] = static_cast<double>(price) / weight;
+
+        std::vector<int>& order = instance_.order;
+        int from = positions_[item];
+        int to = from;
+        if (0 < from && precedes(instance_, item, order[from - 1])) { // предмет подорожал - ищем место левее
+            to = static_cast<int>(std::upper_bound(order.begin(), order.begin() + from, item, [&](int lhs, int rhs) {
+                return precedes(instance_, lhs, rhs);
+            }) - order.begin());
+        } else if (from + 1 < instance_.count && precedes(instance_, order[from + 1], item)) { // подешевел - правее
+            to = static_cast<int>(std::lower_bound(order.begin() + from + 1, order.end(), item, [&](int lhs, int rhs) {
+                return precedes(instance_, lhs, rhs);
+            }) - order.begin()) - 1;
+        }
+        move_position(from, to);
+        instance_.sorted_prices[to] = price;
+        instance_.sorted_weights[to] = weight;
+        return true;
+    }
+
+    // statistics - как в Solver::solve; не меняется, если прошлый ответ подошел без решателя
+    const Solution& resolve(ReductionStatistics* statistics = nullptr) {
+        if (solved_ && bound_valid_) {
+            long long price = 0, weight = 0;
+            for (int item : solution_.items) {
+                price += instance_.prices[item];
+                weight += instance_.weights[item];
+            }
+            if (weight <= instance_.max_weight && price == bound_) {
+                solution_.price = price;
+                solution_.upper_bound = price;
+                ++reused_count_;
+                return solution_;
+            }
+        }
+        std::vector<std::vector<int>> seeds;
+        if (solved_) {
+            seeds.push_back(solution_.items);
+        }
+        solution_ = solver_.solve(instance_, statistics, &seeds, &pool_);
+        solved_ = true;
+        bound_ = solution_.upper_bound;
+        bound_valid_ = 0 <= bound_;
+        return solution_;
+    }
+
+    const Instance& instance() const noexcept {
+        return instance_;
+    }
+
+    const Solution& solution() const noexcept {
+        return solution_;
+    }
+
+    // сколько раз resolve вернул прошлый ответ без решателя
+    long long reused_count() const noexcept {
+        return reused_count_;
+    }
+
+private:
+    // предмет с позиции from в порядке переезжает на позицию to, предметы между ними сдвигаются на одну позицию
+    void move_position(int from, int to) noexcept {
+        auto move = [&](auto& values) {
+            if (from < to) {
+                std::rotate(values.begin() + from, values.begin() + from + 1, values.begin() + to + 1);
+            } else if (to < from) {
+                std::rotate(values.begin() + to, values.begin() + from, values.begin() + from + 1);
+            }
+        };
+        move(instance_.order);
+        move(instance_.sorted_prices);
+        move(instance_.sorted_weights);
+        for (int i = std::min(from, to); i <= std::max(from, to); ++i) {
+            positions_[instance_.order[i]] = i;
+        }
+    }
+
+    const Solver& solver_;
+    Instance instance_;
+    std::vector<int> positions_; // positions_[item] - место предмета в instance_.order
+    Solution solution_;
+    SolutionPool pool_; // последние решения решателя для теплого старта
+    bool solved_ = false;
+    long long bound_ = -1; // верхняя оценка прошлого ответа
+    bool bound_valid_ = false; // оценка верна и для текущей задачи
+    long long reused_count_ = 0;
+};
\ No newline at end of file
@@ -0,0 +1,73 @@
+#pragma once
+
+#include <iostream>
+#include <string>
+#include <vector>
+#include <memory>
+#include <algorithm>
+#include "greedy.h"
+#include "dynamic_programming.h"
+#include "branch_bound.h"
+#include "genetic.h"
+#include "parallel_genetic.h"
+#include "portfolio.h"
+
+// все решатели по порядку; используется программами, которые выбирают решатели при запуске (knapsack.cpp, benchmark_suite.cpp)
+inline std::vector<std::unique_ptr<Solver>> make_solvers() {
+    std::vector<std::unique_ptr<Solver>> solvers;
+    solvers.push_back(std::make_unique<greedy::GreedySolver>());
+    solvers.push_back(std::make_unique<dynamic_programming::DynamicProgrammingSolver>());
+    solvers.push_back(std::make_unique<branch_bound::BranchAndBoundSolver>());
+    solvers.push_back(std::make_unique<genetic::GeneticSolver>());
+    solvers.push_back(std::make_unique<parallel_genetic::ParallelGeneticSolver>());
+    solvers.push_back(std::make_unique<portfolio::PortfolioSolver>());
+    return solvers;
+}
+
+// решатель по имени или nullptr
+inline Solver* find_solver(const std::vector<std::unique_ptr<Solver>>& solvers, const std::string& name) noexcept {
+    auto found = std::find_if(solvers.begin(), solvers.end(), [&](const auto& solver) { return name == solver->name(); });
+    return found == solvers.end() ? nullptr : found->get();
+}
+
+inline void print_unknown_solver(const std::vector<std::unique_ptr<Solver>>& solvers, const std::string& name) {
+    std::cerr << "Error: unknown solver '" << name << "'. Known solvers: ";
+    for (size_t i = 0; i < solvers.size(); ++i) {
+        std::cerr << (i == 0 ? "" : ", ") << solvers[i]->name();
+    }
+    std::cerr << ".\n";
+}
+
+// забирает из argv аргумент --solvers=имя,имя,... (по умолчанию all - все решатели); выбранные решатели записываются в selected по порядку
+inline bool select_solvers(int& argc, char* argv[], const std::vector<std::unique_ptr<Solver>>& solvers, std::vector<Solver*>& selected) {
+    std::string names = "all";
+    int kept = 1;
+    for (int i = 1; i < argc; ++i) {
+        std::string argument = argv[i];
+        if (argument.rfind("--solvers=", 0) == 0) {
+            names = argument.substr(10);
+        } else {
+            argv[kept++] = argv[i];
+        }
+    }
+    argc = kept;
+
+    if (names == "all") {
+        for (const auto& solver : solvers) {
+            selected.push_back(solver.get());
+        }
+        return true;
+    }
+    for (size_t first = 0; first <= names.size();) {
+        size_t last = std::min(names.find(',', first), names.size());
+        std::string name = names.substr(first, last - first);
+        Solver* solver = find_solver(solvers, name);
+        if (solver == nullptr) {
+            print_unknown_solver(solvers, name);
+            return false;
+        }
+        selected.push_back(solver);
+        first = last + 1;
+    }
+    return true;
+}
\ No newline at end of file